@@ -0,0 +1,65 @@
+#include "hash_index.h"
+#include <cassert>
+#include <cfloat>
+#include <climits>
+
+void HashIndex::computeSignature(const TemplateStore &store) {
+    // Checks
+    assert(firstHandle < lastHandle);
+    assert(lastHandle <= store.size());
+
+    minZ = FLT_MAX;
+    maxZ = 0;
+    minWidth = INT_MAX;
+    minHeight = INT_MAX;
+    minEdgelsZ = FLT_MAX;
+
+    for (uint handle = firstHandle; handle < lastHandle; handle++) {
+        minZ = std::min(minZ, store.metadata.translationZ[handle]);
+        maxZ = std::max(maxZ, store.metadata.translationZ[handle]);
+        minWidth = std::min(minWidth, store.metadata.bbWidth[handle]);
+        minHeight = std::min(minHeight, store.metadata.bbHeight[handle]);
+        minEdgelsZ = std::min(minEdgelsZ, store.metadata.edgels[handle] * store.metadata.translationZ[handle]);
+    }
+}
+
+bool HashIndex::accepts(const Window &window, float depthBand, float edgelsFactor, int maxWidth, int maxHeight) const {
+    // Single global index (objId -1) routes every window, depth and edgel routing applies only to per-object indices
+    if (objId < 0) {
+        return true;
+    }
+
+    // Depth band of the window must overlap range of rendering distances (unknown depth passes)
+    if (depthBand > 0 && window.depth > 0) {
+        if (window.depth * (1 + depthBand) < minZ || window.depth * (1 - depthBand) > maxZ) {
+            return false;
+        }
+    }
+
+    // Window must contain at least edgelsFactor of edgels of the object with the least edgels, rescaled
+    // to window depth (objects differ in size and shape, so their edgel counts tell them apart)
+    if (window.depth > 0 && window.edgels * window.depth < minEdgelsZ * edgelsFactor) {
+        return false;
+    }
+
+    // At least the smallest template must fit into the scene at window location
+    return minWidth <= maxWidth && minHeight <= maxHeight;
+}
+
+size_t HashIndex::templateCount() const {
+    return lastHandle - firstHandle;
+}
+
+size_t HashIndex::firstWord() const {
+    return firstHandle / 64;
+}
+
+size_t HashIndex::wordCount() const {
+    return (lastHandle + 63) / 64 - firstWord();
+}
+
+std::ostream &operator<<(std::ostream &os, const HashIndex &index) {
+    os << "objId: " << index.objId << " templates: <" << index.firstHandle << ", " << index.lastHandle << ")"
+       << " z: <" << index.minZ << ", " << index.maxZ << "> edgels * z: " << index.minEdgelsZ << " tables: " << index.hashTables.size();
+    return os;
+}
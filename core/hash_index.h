@@ -0,0 +1,49 @@
+#ifndef VSB_SEMESTRAL_PROJECT_HASH_INDEX_H
+#define VSB_SEMESTRAL_PROJECT_HASH_INDEX_H
+
+#include <vector>
+#include <opencv2/core/types.hpp>
+#include "hash_table.h"
+#include "template_store.h"
+#include "window.h"
+
+/**
+ * struct HashIndex
+ *
+ * Set of hash tables trained on continuous range of templates in TemplateStore, either the whole
+ * catalog or templates of one object. Triplets and depth bins are shared by all indices, so hash keys
+ * are extracted once per window, each index uses only a slice of shared triplets (tableIds). A cheap
+ * signature (range of rendering distances, smallest template size and smallest depth edgel count)
+ * routes windows only to per-object indices which can contain matching templates, global index accepts all.
+ */
+struct HashIndex {
+public:
+    int objId; // Object id of indexed templates, -1 if index contains all objects
+    uint firstHandle; // Indexed templates are handles in <firstHandle, lastHandle)
+    uint lastHandle;
+    std::vector<HashTable> hashTables;
+    std::vector<uint> tableIds; // Shared triplet (index of hash key extracted per window) of each hash table
+
+    // Router signature
+    float minZ; // Min and max translation z (rendering distance) of indexed templates
+    float maxZ;
+    int minWidth; // Smallest objBB size of indexed templates
+    int minHeight;
+    float minEdgelsZ; // Smallest edgels * translation z of indexed templates (edgels scale with z / scene depth)
+
+    // Constructors
+    HashIndex(int objId = -1, uint firstHandle = 0, uint lastHandle = 0)
+        : objId(objId), firstHandle(firstHandle), lastHandle(lastHandle), minZ(0), maxZ(0), minWidth(0), minHeight(0), minEdgelsZ(0) {}
+
+    // Methods
+    void computeSignature(const TemplateStore &store);
+    bool accepts(const Window &window, float depthBand, float edgelsFactor, int maxWidth, int maxHeight) const;
+    size_t templateCount() const;
+    size_t firstWord() const; // First word of template bitsets covering indexed templates
+    size_t wordCount() const;
+
+    // Operators
+    friend std::ostream &operator<<(std::ostream &os, const HashIndex &index);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_HASH_INDEX_H
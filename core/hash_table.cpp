@@ -1,11 +1,27 @@
 #include "hash_table.h"
 
+void HashTable::buildBitsets(uint firstHandle, uint lastHandle) {
+    // Only words covering <firstHandle, lastHandle) are stored
+    bitsetOffset = firstHandle / 64;
+    const size_t words = (lastHandle + 63) / 64 - bitsetOffset;
+    bitsets.clear();
+
+    for (const auto &entry : templates) {
+        TemplateBitset &bitset = bitsets[entry.first];
+        bitset.assign(words, 0);
+
+        for (const auto &handle : entry.second) {
+            bitset[handle / 64 - bitsetOffset] |= (1ULL << (handle % 64));
+        }
+    }
+}
+
 std::ostream &operator<<(std::ostream &os, const HashTable &table) {
-    os << "Triplet " << table.triplet << std::endl;
+    os << "Triplet " << table.triplet << "seed: " << table.seed << " stream: " << table.stream << std::endl;
     for (const auto &entry : table.templates) {
         os << entry.first << " : (";
         for (const auto &item : entry.second) {
-            os << item->id << ", ";
+            os << item << ", ";
         }
         os << ")" << std::endl;
     }
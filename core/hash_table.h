@@ -6,21 +6,35 @@
 #include "template.h"
 #include <unordered_map>
 #include <ostream>
+#include <cstdint>
+
+// Set of templates, bit i of word i / 64 is set if template with handle i is present
+typedef std::vector<uint64_t> TemplateBitset;
 
 /**
  * struct HashTable
  *
  * Hash table used to store trained templates with discretizied values into
- * coresponding bins, forming hash key of (d1, d2, n1, n2, n3)
+ * coresponding bins, forming hash key of (d1, d2, n1, n2, n3). Templates are
+ * stored as handles into TemplateStore. Seed and stream of random generator the triplet
+ * was drawn from are recorded, so the triplet can be reproduced. Each bin is also stored
+ * as template bitset (built after training) used by bitset voting.
  */
 struct HashTable {
 public:
     Triplet triplet;
-    std::unordered_map<HashKey, std::vector<Template *>, HashKeyHasher> templates;
+    uint64_t seed;
+    uint64_t stream;
+    std::unordered_map<HashKey, std::vector<uint>, HashKeyHasher> templates;
+    std::unordered_map<HashKey, TemplateBitset, HashKeyHasher> bitsets;
+    size_t bitsetOffset; // Bitsets start at word bitsetOffset of full catalog bitset
 
     // Constructors
-    HashTable() {}
-    HashTable(Triplet triplet) : triplet(triplet){}
+    HashTable() : seed(0), stream(0), bitsetOffset(0) {}
+    HashTable(Triplet triplet, uint64_t seed = 0, uint64_t stream = 0) : triplet(triplet), seed(seed), stream(stream), bitsetOffset(0) {}
+
+    // Methods
+    void buildBitsets(uint firstHandle, uint lastHandle);
 
     // Operators
     friend std::ostream &operator<<(std::ostream &os, const HashTable &table);
@@ -0,0 +1,27 @@
+#include "random_stream.h"
+#include <cmath>
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream) : counter(0), seed(seed), stream(stream) {
+    // Key of the stream derived from both seed and stream index
+    key = mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ULL));
+}
+
+uint64_t RandomStream::mix(uint64_t z) {
+    // SplitMix64 finalizer
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t RandomStream::next() {
+    return mix(key + (++counter) * 0x9E3779B97F4A7C15ULL);
+}
+
+float RandomStream::uniform() {
+    // Top 24 bits give all representable floats in <0, 1) with equal spacing
+    return static_cast<float>(next() >> 40) / static_cast<float>(1 << 24);
+}
+
+float RandomStream::uniform(float rangeMin, float rangeMax) {
+    return roundf(uniform() * (rangeMax - rangeMin) + rangeMin);
+}
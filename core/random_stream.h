@@ -0,0 +1,32 @@
+#ifndef VSB_SEMESTRAL_PROJECT_RANDOM_STREAM_H
+#define VSB_SEMESTRAL_PROJECT_RANDOM_STREAM_H
+
+#include <cstdint>
+
+/**
+ * struct RandomStream
+ *
+ * Counter-based random number generator. Each value is a hash of (seed, stream, counter), so there
+ * is no shared state between streams. Every thread (or every generated item) can use its own stream
+ * without locking, and results don't depend on number of threads or on scheduling.
+ */
+struct RandomStream {
+private:
+    uint64_t key;
+    uint64_t counter;
+
+    static uint64_t mix(uint64_t z);
+public:
+    uint64_t seed;
+    uint64_t stream;
+
+    // Constructors
+    RandomStream(uint64_t seed = 1, uint64_t stream = 0);
+
+    // Methods
+    uint64_t next();
+    float uniform(); // <0, 1)
+    float uniform(float rangeMin, float rangeMax); // Rounded value in <rangeMin, rangeMax>
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_RANDOM_STREAM_H
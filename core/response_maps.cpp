@@ -0,0 +1,56 @@
+#include "response_maps.h"
+#include <cassert>
+
+void ResponseMaps::create(int orientations, int step, int width, int height) {
+    // Checks
+    assert(orientations > 0);
+    assert(step > 0);
+
+    this->step = step;
+    cols = width / step;
+    rows = height / step;
+
+    memories.resize(orientations);
+    for (auto &&m : memories) {
+        m = cv::Mat::zeros(step * step, rows * cols, CV_8UC1);
+    }
+}
+
+void ResponseMaps::clear() {
+    memories.clear();
+    step = 0;
+    cols = 0;
+    rows = 0;
+}
+
+bool ResponseMaps::empty() const {
+    return memories.empty();
+}
+
+ResponseMaps ResponseMaps::clone() const {
+    ResponseMaps copy;
+    copy.step = step;
+    copy.cols = cols;
+    copy.rows = rows;
+
+    for (auto &&m : memories) {
+        copy.memories.push_back(m.clone());
+    }
+
+    return copy;
+}
+
+uchar *ResponseMaps::memory(int orientation, int x, int y) {
+    assert(x >= 0 && y >= 0 && x < cols * step && y < rows * step);
+    return memories[orientation].ptr<uchar>((y % step) * step + x % step) + (y / step) * cols + x / step;
+}
+
+const uchar *ResponseMaps::memory(int orientation, int x, int y) const {
+    assert(x >= 0 && y >= 0 && x < cols * step && y < rows * step);
+    return memories[orientation].ptr<uchar>((y % step) * step + x % step) + (y / step) * cols + x / step;
+}
+
+uchar ResponseMaps::at(int orientation, int x, int y) const {
+    if (x < 0 || y < 0 || x >= cols * step || y >= rows * step) return 0;
+    return *memory(orientation, x, y);
+}
@@ -0,0 +1,37 @@
+#ifndef VSB_SEMESTRAL_PROJECT_RESPONSE_MAPS_H
+#define VSB_SEMESTRAL_PROJECT_RESPONSE_MAPS_H
+
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+/**
+ * struct ResponseMaps
+ *
+ * Gradient response maps of all orientations stored in linearized layout (LINE-MOD linear memories).
+ * Each map is split into step x step memories, memory (y % step) * step + (x % step) holds responses
+ * of pixels (x, y) in grid of cols x rows cells, cell (x / step, y / step) at index (y / step) * cols + x / step.
+ * Responses of one template point at all locations with stride step are then stored contiguously,
+ * so evaluating the point over the whole search area is a sequential add instead of random access.
+ * Pixels outside of cols * step x rows * step area have no response.
+ */
+struct ResponseMaps {
+public:
+    int step;
+    int cols; // Grid width, width of map / step
+    int rows; // Grid height, height of map / step
+    std::vector<cv::Mat> memories; // memories[orientation] is CV_8UC1 of step * step rows, each with rows * cols cells
+
+    // Constructors
+    ResponseMaps() : step(0), cols(0), rows(0) {}
+
+    // Methods
+    void create(int orientations, int step, int width, int height);
+    void clear();
+    bool empty() const;
+    ResponseMaps clone() const; // Deep copy of all memories
+    uchar *memory(int orientation, int x, int y); // Pointer to response of pixel (x, y) within its memory
+    const uchar *memory(int orientation, int x, int y) const;
+    uchar at(int orientation, int x, int y) const; // Response of pixel (x, y), 0 outside of the grid
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_RESPONSE_MAPS_H
@@ -9,35 +9,57 @@
  * struct Template
  *
  * Template parse and downloaded from dataset http://cmp.felk.cvut.cz/t-less/
- * used across all matching process at all sorts of places
+ * used across all matching process at all sorts of places. Images are stored in their
+ * native compact form, src as 8-bit intensity (CV_8UC1) and srcDepth as 16-bit depth (CV_16UC1),
+ * color is kept only as quantized hue (srcHue, CV_8UC1) when color test is used.
+ * Foreground (non-black pixels of src) is stored as run-length encoded row spans bounded by innerBB,
+ * so loops over the object don't have to test and skip background pixels.
  */
 struct Template {
 public:
+    // Run of foreground pixels <x, x + length) in row y of src
+    struct Span {
+        int y;
+        int x;
+        int length;
+
+        Span(int y, int x, int length) : y(y), x(x), length(length) {}
+    };
+
     int id;
+    int objId;
     std::string fileName;
-    cv::Mat src;
-    cv::Mat srcDepth;
+    cv::Mat src; // CV_8UC1
+    cv::Mat srcDepth; // CV_16UC1
+    cv::Mat srcHue; // Quantized hue, CV_8UC1 (empty if color isn't quantized)
+    cv::Mat srcPyramid; // src downsampled for coarse matching pass, CV_8UC1 (empty if not used)
+    cv::Mat srcNormals; // Surface normals estimated by plane fit, CV_32FC3 (empty if normals aren't estimated)
 
     // Template .yml parameters
     cv::Rect objBB; // Object bounding box
-    cv::Mat camK; // Intrinsic camera matrix K
-    cv::Mat camRm2c; // Rotation matrix R_m2c
+    cv::Matx33f camK; // Intrinsic camera matrix K
+    cv::Matx33f camRm2c; // Rotation matrix R_m2c
     cv::Vec3f camTm2c; // Translation vector t_m2c
     int elev;
     int mode;
 
-    // Hashing args
-    int votes;
+    // Foreground mask of src
+    std::vector<Span> foregroundSpans; // Row spans sorted by y and x
+    cv::Rect innerBB; // Tight bounding box of foreground (src coordinates)
+    int foregroundArea; // Number of foreground pixels
+
+    // Feature points used in template matching (src coordinates)
+    std::vector<cv::Point> featurePoints;
+    std::vector<float> featureEnergyTail; // Sum of squared src intensities of feature points i..end (empty if not ordered)
+    std::vector<cv::Vec3f> featureNormals; // Surface normals at feature points (empty if normals aren't estimated)
+    std::vector<cv::Point> gradientPoints; // Points with strong gradient used in gradient test (src coordinates)
+    std::vector<uchar> gradientOrientations; // Quantized orientation (bin index) of each gradient point
+    std::vector<uchar> featureHues; // Hue bins at feature points (empty if color isn't quantized)
 
     // Constructors
-    Template(int id, std::string fileName, cv::Mat src, cv::Mat srcDepth, cv::Rect objBB, cv::Mat camRm2c, cv::Vec3d camTm2c)
-            : votes(0), id(id), fileName(fileName), src(src), srcDepth(srcDepth), objBB(objBB), camRm2c(camRm2c), camTm2c(camTm2c) {}
-
-    // Methods
-    void voteUp();
-    void resetVotes();
-    void applyROI();
-    void resetROI();
+    Template(int id, int objId, std::string fileName, cv::Mat src, cv::Mat srcDepth, cv::Rect objBB, cv::Matx33f camRm2c, cv::Vec3d camTm2c)
+            : id(id), objId(objId), fileName(fileName), src(src), srcDepth(srcDepth), objBB(objBB), camRm2c(camRm2c), camTm2c(camTm2c),
+              foregroundArea(0) {}
 
     // Operators
     bool operator==(const Template &rhs) const;
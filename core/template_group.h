@@ -8,17 +8,16 @@
  * struct TemplateGroup
  *
  * Simple structure, served only for purpose of separating each parsed template
- * into it's own group
+ * into it's own group, templates itself are owned by TemplateStore
  */
 struct TemplateGroup {
 public:
     std::string folderName;
-    std::vector<Template> templates;
+    std::vector<uint> templates; // Handles of templates in TemplateStore
 
     // Constructors
     TemplateGroup() {}
-    TemplateGroup(std::string folderName, std::vector<Template> templates)
-            : folderName(folderName), templates(templates) {}
+    TemplateGroup(std::string folderName) : folderName(folderName) {}
 };
 
 #endif //VSB_SEMESTRAL_PROJECT_TEMPLATE_GROUP_H
@@ -7,11 +7,12 @@
 struct TemplateMatch {
 public:
     cv::Point tl;
-    Template *t;
-    uint score;
+    uint handle; // Handle of matched template in TemplateStore
+    float score;
+    float scale; // Scale of matched template (window depth vs template rendering distance)
 
     // Constructors
-    TemplateMatch(cv::Point tl, Template *t, uint score = 0) : tl(tl), t(t), score(score) {}
+    TemplateMatch(cv::Point tl, uint handle, float score = 0, float scale = 1) : tl(tl), handle(handle), score(score), scale(scale) {}
 
     // Friends
     bool operator==(const TemplateMatch &rhs) const;
@@ -0,0 +1,76 @@
+#include "template_metadata.h"
+#include <cassert>
+#include <algorithm>
+
+void TemplateMetadata::push(const Template &t) {
+    bbWidth.push_back(t.objBB.width);
+    bbHeight.push_back(t.objBB.height);
+    objId.push_back(t.objId);
+    elev.push_back(t.elev);
+    mode.push_back(t.mode);
+    translationZ.push_back(t.camTm2c[2]);
+    edgels.push_back(0);
+    votes.push_back(0);
+
+    // Keep depth index sorted, insert new handle after all templates with same or lower depth
+    const uint handle = static_cast<uint>(votes.size() - 1);
+    const float z = translationZ[handle];
+    auto it = std::upper_bound(depthIndex.begin(), depthIndex.end(), z, [this](float value, uint h) {
+        return value < translationZ[h];
+    });
+    depthIndex.insert(it, handle);
+}
+
+void TemplateMetadata::clear() {
+    bbWidth.clear();
+    bbHeight.clear();
+    objId.clear();
+    elev.clear();
+    mode.clear();
+    translationZ.clear();
+    edgels.clear();
+    votes.clear();
+    depthIndex.clear();
+}
+
+size_t TemplateMetadata::size() const {
+    return votes.size();
+}
+
+void TemplateMetadata::resetVotes() {
+    std::fill(votes.begin(), votes.end(), 0);
+}
+
+void TemplateMetadata::filterSize(int maxWidth, int maxHeight, std::vector<uchar> &mask) const {
+    // Checks
+    assert(mask.size() == size());
+
+    const int count = static_cast<int>(size());
+    const int *pWidth = bbWidth.data(), *pHeight = bbHeight.data();
+    uchar *pMask = mask.data();
+
+    // Branchless loop, so it can be vectorized
+    for (int i = 0; i < count; i++) {
+        pMask[i] &= static_cast<uchar>((pWidth[i] <= maxWidth) & (pHeight[i] <= maxHeight));
+    }
+}
+
+size_t TemplateMetadata::selectDepth(float minZ, float maxZ, std::vector<uchar> &mask) const {
+    // Checks
+    assert(mask.size() == size());
+    assert(minZ <= maxZ);
+
+    // Find range of templates in depth band
+    auto first = std::lower_bound(depthIndex.begin(), depthIndex.end(), minZ, [this](uint h, float value) {
+        return translationZ[h] < value;
+    });
+    auto last = std::upper_bound(first, depthIndex.end(), maxZ, [this](float value, uint h) {
+        return value < translationZ[h];
+    });
+
+    for (auto it = first; it != last; ++it) {
+        mask[*it] = 1;
+    }
+
+    return static_cast<size_t>(last - first);
+}
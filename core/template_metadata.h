@@ -0,0 +1,41 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TEMPLATE_METADATA_H
+#define VSB_SEMESTRAL_PROJECT_TEMPLATE_METADATA_H
+
+#include <vector>
+#include "template.h"
+
+/**
+ * struct TemplateMetadata
+ *
+ * Scalar parameters of all templates in TemplateStore stored as structure of arrays,
+ * i-th element of each array belongs to template with handle i. Filters over all templates
+ * then run over contiguous arrays (which compiler can vectorize) instead of chasing
+ * Template objects. Hashing votes are kept here as well. Handles are additionally indexed
+ * by rendering distance (depthIndex), so templates in depth band are selected by binary search.
+ */
+struct TemplateMetadata {
+public:
+    std::vector<int> bbWidth; // Width of objBB
+    std::vector<int> bbHeight; // Height of objBB
+    std::vector<int> objId;
+    std::vector<int> elev;
+    std::vector<int> mode;
+    std::vector<float> translationZ; // z coordinate of camTm2c (rendering distance)
+    std::vector<int> edgels; // Depth edgels of template, set by Objectness::extractMinEdgels (0 until then)
+    std::vector<int> votes;
+    std::vector<uint> depthIndex; // Handles sorted by translationZ (ASC)
+
+    // Methods
+    void push(const Template &t);
+    void clear();
+    size_t size() const;
+    void resetVotes();
+
+    // Filters, mask[i] is set to 0 for each template which doesn't pass
+    void filterSize(int maxWidth, int maxHeight, std::vector<uchar> &mask) const;
+
+    // Sets mask[i] to 1 for each template with translationZ in <minZ, maxZ>, returns their count
+    size_t selectDepth(float minZ, float maxZ, std::vector<uchar> &mask) const;
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TEMPLATE_METADATA_H
@@ -0,0 +1,81 @@
+#include "template_store.h"
+#include <cassert>
+
+const size_t TemplateStore::ARENA_ALIGNMENT = 16;
+
+uchar *TemplateStore::allocate(size_t bytes) {
+    // Align every image to ARENA_ALIGNMENT bytes
+    bytes = (bytes + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    assert(arenaOffset + bytes <= arenaSize);
+
+    uchar *ptr = arena.get() + arenaOffset;
+    arenaOffset += bytes;
+
+    return ptr;
+}
+
+uint TemplateStore::push(const Template &t) {
+    // Arena can't be resized once images point into it
+    assert(!arena);
+    templates.push_back(t);
+    metadata.push(t);
+
+    return static_cast<uint>(templates.size() - 1);
+}
+
+void TemplateStore::allocateArena(bool hue) {
+    // Checks
+    assert(!arena);
+    assert(!templates.empty());
+
+    // Calculate size of all images (8-bit intensity + 16-bit depth + optional 8-bit hue) of each template
+    arenaSize = 0;
+    for (auto &t : templates) {
+        size_t area = static_cast<size_t>(t.objBB.area());
+        arenaSize += ((area * sizeof(uchar) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1));
+        arenaSize += ((area * sizeof(ushort) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1));
+        if (hue) arenaSize += ((area * sizeof(uchar) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1));
+    }
+
+    // Allocate whole arena at once (+ alignment of the first image)
+    arena.reset(new uchar[arenaSize + ARENA_ALIGNMENT]);
+    arenaOffset = (ARENA_ALIGNMENT - reinterpret_cast<size_t>(arena.get()) % ARENA_ALIGNMENT) % ARENA_ALIGNMENT;
+    arenaSize += arenaOffset;
+
+    // Create image headers pointing into the arena
+    for (auto &t : templates) {
+        t.src = cv::Mat(t.objBB.height, t.objBB.width, CV_8UC1, allocate(t.objBB.area() * sizeof(uchar)));
+        t.srcDepth = cv::Mat(t.objBB.height, t.objBB.width, CV_16UC1, allocate(t.objBB.area() * sizeof(ushort)));
+        if (hue) t.srcHue = cv::Mat(t.objBB.height, t.objBB.width, CV_8UC1, allocate(t.objBB.area() * sizeof(uchar)));
+    }
+}
+
+void TemplateStore::clear() {
+    templates.clear();
+    metadata.clear();
+    arena.reset();
+    arenaSize = 0;
+    arenaOffset = 0;
+}
+
+bool TemplateStore::empty() const {
+    return templates.empty();
+}
+
+size_t TemplateStore::size() const {
+    return templates.size();
+}
+
+size_t TemplateStore::getArenaSize() const {
+    return arenaSize;
+}
+
+Template &TemplateStore::operator[](uint handle) {
+    assert(handle < templates.size());
+    return templates[handle];
+}
+
+const Template &TemplateStore::operator[](uint handle) const {
+    assert(handle < templates.size());
+    return templates[handle];
+}
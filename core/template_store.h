@@ -0,0 +1,46 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TEMPLATE_STORE_H
+#define VSB_SEMESTRAL_PROJECT_TEMPLATE_STORE_H
+
+#include <memory>
+#include <vector>
+#include "template.h"
+#include "template_metadata.h"
+
+/**
+ * struct TemplateStore
+ *
+ * Owns all parsed templates of the catalog. Templates are referenced across the pipeline
+ * (hash tables, windows, matches) by integer handles, which are indices into the store and stay
+ * valid when the store grows. Pixel data of all templates is allocated from single arena
+ * (one allocation per catalog), src, srcDepth (and srcHue) are only headers pointing into it.
+ * Scalar params of all templates are mirrored in metadata (structure of arrays).
+ */
+struct TemplateStore {
+private:
+    std::unique_ptr<uchar[]> arena;
+    size_t arenaSize;
+    size_t arenaOffset;
+
+    uchar *allocate(size_t bytes);
+public:
+    static const size_t ARENA_ALIGNMENT;
+    std::vector<Template> templates;
+    TemplateMetadata metadata;
+
+    // Constructors
+    TemplateStore() : arenaSize(0), arenaOffset(0) {}
+
+    // Methods
+    uint push(const Template &t);
+    void allocateArena(bool hue = false);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    size_t getArenaSize() const;
+
+    // Operators
+    Template &operator[](uint handle);
+    const Template &operator[](uint handle) const;
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TEMPLATE_STORE_H
@@ -0,0 +1,117 @@
+#include "template_tree.h"
+#include <cassert>
+#include <cfloat>
+#include <map>
+#include <algorithm>
+#include "viewpoint_graph.h"
+
+void TemplateTree::split(const TemplateStore &store, uint node, uint branching, uint leafSize) {
+    const uint first = nodes[node].first, last = nodes[node].last;
+    if (last - first <= leafSize) return;
+
+    // Farthest point sampling of cluster centres, first centre is representative of the node
+    std::vector<uint> centres(1, nodes[node].representative);
+    std::vector<float> distances(last - first, FLT_MAX);
+    while (centres.size() < branching) {
+        const cv::Matx33f &r = store[centres.back()].camRm2c;
+        size_t farthest = 0;
+
+        for (uint i = first; i < last; i++) {
+            distances[i - first] = std::min(distances[i - first], ViewpointGraph::geodesicDistance(r, store[order[i]].camRm2c));
+            if (distances[i - first] > distances[farthest]) farthest = i - first;
+        }
+
+        if (distances[farthest] <= 0) break;
+        centres.push_back(order[first + farthest]);
+    }
+
+    // All templates have the same viewpoint, node stays leaf
+    if (centres.size() < 2) return;
+
+    // Assign each template to nearest centre
+    std::vector<std::pair<uint, uint>> assigned; // (cluster, handle)
+    for (uint i = first; i < last; i++) {
+        const cv::Matx33f &r = store[order[i]].camRm2c;
+        uint nearest = 0;
+        float nearestDistance = FLT_MAX;
+
+        for (uint c = 0; c < centres.size(); c++) {
+            float distance = ViewpointGraph::geodesicDistance(r, store[centres[c]].camRm2c);
+            if (distance < nearestDistance) {
+                nearestDistance = distance;
+                nearest = c;
+            }
+        }
+
+        assigned.push_back(std::make_pair(nearest, order[i]));
+    }
+
+    // Reorder templates of the node by cluster, so each child is continuous range
+    std::stable_sort(assigned.begin(), assigned.end(), [](const std::pair<uint, uint> &a, const std::pair<uint, uint> &b) {
+        return a.first < b.first;
+    });
+    for (uint i = first; i < last; i++) {
+        order[i] = assigned[i - first].second;
+        positions[order[i]] = i;
+    }
+
+    // Create children and split them recursively (nodes can reallocate, so node is accessed by index)
+    for (uint c = 0, i = first; c < centres.size(); c++) {
+        uint childFirst = i;
+        while (i < last && assigned[i - first].first == c) i++;
+        if (childFirst == i) continue;
+
+        nodes.push_back(Node(centres[c], childFirst, i));
+        const uint child = static_cast<uint>(nodes.size() - 1);
+        nodes[node].children.push_back(child);
+        split(store, child, branching, leafSize);
+    }
+}
+
+void TemplateTree::build(const TemplateStore &store, uint branching, uint leafSize) {
+    // Checks
+    assert(!store.empty());
+    assert(branching > 1);
+    assert(leafSize > 0);
+
+    clear();
+    positions.resize(store.size());
+
+    // Group handles of each object, each object has its own root
+    std::map<int, std::vector<uint>> objects;
+    for (uint handle = 0; handle < store.size(); handle++) {
+        objects[store.metadata.objId[handle]].push_back(handle);
+    }
+
+    for (auto &&object : objects) {
+        const uint first = static_cast<uint>(order.size());
+        for (auto &&handle : object.second) {
+            positions[handle] = static_cast<uint>(order.size());
+            order.push_back(handle);
+        }
+
+        nodes.push_back(Node(object.second[0], first, static_cast<uint>(order.size())));
+        roots.push_back(static_cast<uint>(nodes.size() - 1));
+        split(store, roots.back(), branching, leafSize);
+    }
+}
+
+void TemplateTree::clear() {
+    nodes.clear();
+    roots.clear();
+    order.clear();
+    positions.clear();
+}
+
+bool TemplateTree::empty() const {
+    return nodes.empty();
+}
+
+size_t TemplateTree::size() const {
+    return order.size();
+}
+
+bool TemplateTree::isLeaf(uint node) const {
+    assert(node < nodes.size());
+    return nodes[node].children.empty();
+}
@@ -0,0 +1,43 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TEMPLATE_TREE_H
+#define VSB_SEMESTRAL_PROJECT_TEMPLATE_TREE_H
+
+#include <vector>
+#include "template_store.h"
+
+/**
+ * struct TemplateTree
+ *
+ * Hierarchical clustering of templates of each object by viewpoint (rotation geodesic distance).
+ * Every object has its own root, each inner node is split into at most branching clusters
+ * (farthest point sampling of centres), until nodes contain at most leafSize templates. Each child
+ * node is represented by template in its cluster centre, roots by first template of the object (it only
+ * seeds sampling of centres, roots themselves aren't scored). Templates of each subtree are continuous range
+ * <first, last) of order, so test whether subtree contains a handle is a range check of its position.
+ */
+struct TemplateTree {
+public:
+    struct Node {
+        uint representative; // Handle of template in cluster centre (first template of the object in roots)
+        uint first; // Templates of subtree are order[first] ... order[last - 1]
+        uint last;
+        std::vector<uint> children; // Indices of child nodes, empty in leaves
+
+        Node(uint representative, uint first, uint last) : representative(representative), first(first), last(last) {}
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint> roots; // Root node of each object
+    std::vector<uint> order; // Handles ordered so that each subtree is continuous range
+    std::vector<uint> positions; // positions[handle] is index of handle in order
+
+    // Methods
+    void build(const TemplateStore &store, uint branching, uint leafSize);
+    void clear();
+    bool empty() const;
+    size_t size() const; // Number of templates in tree
+    bool isLeaf(uint node) const;
+private:
+    void split(const TemplateStore &store, uint node, uint branching, uint leafSize);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TEMPLATE_TREE_H
@@ -1,49 +1,43 @@
-#include <random>
-#include <functional>
 #include <iostream>
 #include <cassert>
 #include <opencv2/core/mat.hpp>
 #include <opencv/cv.hpp>
 #include "triplet.h"
 
-typedef std::mt19937 Engine;
-typedef std::uniform_real_distribution<float> Distribution;
-auto uniformGenerator = std::bind(Distribution(0.0f, 1.0f), Engine(1));
-
-cv::Point Triplet::randomPoint(const cv::Size referencePointsGrid) {
+cv::Point Triplet::randomPoint(RandomStream &rng, const cv::Size referencePointsGrid) {
     return cv::Point(
-        static_cast<int>(random(0, referencePointsGrid.width - 1)),
-        static_cast<int>(random(0, referencePointsGrid.height - 1))
+        static_cast<int>(rng.uniform(0, referencePointsGrid.width - 1)),
+        static_cast<int>(rng.uniform(0, referencePointsGrid.height - 1))
     );
 }
 
-cv::Point Triplet::randomPointBoundaries(int min, int max) {
-    int y = static_cast<int>(random(min, max));
-    int x = static_cast<int>(random(min, max));
+cv::Point Triplet::randomPointBoundaries(RandomStream &rng, int min, int max) {
+    int y = static_cast<int>(rng.uniform(min, max));
+    int x = static_cast<int>(rng.uniform(min, max));
 
     // Check if x || y equals zero, if yes, generate again
     while (x == 0 || y == 0) {
-        y = static_cast<int>(random(min, max));
-        x = static_cast<int>(random(min, max));
+        y = static_cast<int>(rng.uniform(min, max));
+        x = static_cast<int>(rng.uniform(min, max));
     }
 
     return cv::Point(x, y);
 }
 
-Triplet Triplet::createRandomTriplet(const cv::Size &referencePointsGrid, int maxNeighbourhood) {
+Triplet Triplet::createRandomTriplet(RandomStream &rng, const cv::Size &referencePointsGrid, int maxNeighbourhood) {
     // Checks
     assert(referencePointsGrid.width > 0);
     assert(referencePointsGrid.height > 0);
 
     // Generate points
     cv::Point p1, p2;
-    cv::Point c(randomPoint(referencePointsGrid));
+    cv::Point c(randomPoint(rng, referencePointsGrid));
 
     // Generate other 2 random points within boundaries to the center
     // and check for duplicates and valid coordinates
     do {
-        p1 = cv::Point(c + randomPointBoundaries(-maxNeighbourhood, maxNeighbourhood));
-        p2 = cv::Point(c + randomPointBoundaries(-maxNeighbourhood, maxNeighbourhood));
+        p1 = cv::Point(c + randomPointBoundaries(rng, -maxNeighbourhood, maxNeighbourhood));
+        p2 = cv::Point(c + randomPointBoundaries(rng, -maxNeighbourhood, maxNeighbourhood));
 
         // Check for negative values (simply multiply by -1 to get positive)
         if (p1.x < 0) p1.x *= -1;
@@ -138,17 +132,6 @@ cv::Point Triplet::getP2Coords(const TripletCoords &coordinateParams) {
 }
 
 
-float Triplet::random(const float rangeMin, const float rangeMax) {
-    float rnd;
-
-    #pragma omp critical (random)
-    {
-        rnd = static_cast<float>(uniformGenerator());
-    }
-
-    return roundf(rnd * (rangeMax - rangeMin) + rangeMin);
-}
-
 void Triplet::visualize(const cv::Mat &src, const cv::Size &referencePointsGrid, bool grid) {
     // Checks
     assert(!src.empty());
@@ -3,6 +3,7 @@
 
 #include <opencv2/core/types.hpp>
 #include <ostream>
+#include "random_stream.h"
 
 /**
  * struct TripletCoords
@@ -29,20 +30,20 @@ public:
  *
  * All generated points are stored in relative locations, we use 12x12 reference points, so every
  * point has x and y coordinates in interval <0, 11>. This allows to adapt reference point locations
- * to each template bounding box.
+ * to each template bounding box. Random triplets are drawn from given RandomStream, so they can be
+ * generated in parallel and reproduced from the stream seed.
  */
 struct Triplet {
 private:
-    inline static cv::Point randomPoint(const cv::Size referencePointsGrid);
-    inline static cv::Point randomPointBoundaries(int min = -4, int max = 4);
+    inline static cv::Point randomPoint(RandomStream &rng, const cv::Size referencePointsGrid);
+    inline static cv::Point randomPointBoundaries(RandomStream &rng, int min = -4, int max = 4);
 public:
     cv::Point c;
     cv::Point p1;
     cv::Point p2;
 
     // Statics
-    static float random(const float rangeMin = 0.0f, const float rangeMax = 1.0f);
-    static Triplet createRandomTriplet(const cv::Size &referencePointsGrid, int maxNeighbourhood = 3);
+    static Triplet createRandomTriplet(RandomStream &rng, const cv::Size &referencePointsGrid, int maxNeighbourhood = 3);
     static TripletCoords getCoordParams(const int width, const int height, const cv::Size &referencePointsGrid, int sceneOffsetX = 0, int sceneOffsetY = 0);
 
     // Constructors
@@ -0,0 +1,31 @@
+#include "triplet_layout.h"
+#include <cassert>
+
+TripletLayout::TripletLayout(cv::Size windowSize, size_t rowStride, const std::vector<HashTable> &hashTables, const cv::Size &referencePointsGrid)
+    : windowSize(windowSize), rowStride(rowStride) {
+    // Checks
+    assert(windowSize.width > 0 && windowSize.height > 0);
+    assert(rowStride >= static_cast<size_t>(windowSize.width));
+    assert(!hashTables.empty());
+
+    // Same float math as Triplet::getCoords, done once per window size instead of once per window
+    TripletCoords coordParams = Triplet::getCoordParams(windowSize.width, windowSize.height, referencePointsGrid);
+    for (auto &&table : hashTables) {
+        Triplet triplet = table.triplet;
+        c.push_back(triplet.getCenterCoords(coordParams));
+        p1.push_back(triplet.getP1Coords(coordParams));
+        p2.push_back(triplet.getP2Coords(coordParams));
+
+        cOffsets.push_back(static_cast<int>(c.back().y * rowStride + c.back().x));
+        p1Offsets.push_back(static_cast<int>(p1.back().y * rowStride + p1.back().x));
+        p2Offsets.push_back(static_cast<int>(p2.back().y * rowStride + p2.back().x));
+    }
+}
+
+bool TripletLayout::isCompiledFor(cv::Size windowSize, size_t rowStride) const {
+    return this->windowSize == windowSize && this->rowStride == rowStride;
+}
+
+size_t TripletLayout::size() const {
+    return cOffsets.size();
+}
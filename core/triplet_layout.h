@@ -0,0 +1,32 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TRIPLET_LAYOUT_H
+#define VSB_SEMESTRAL_PROJECT_TRIPLET_LAYOUT_H
+
+#include <vector>
+#include <opencv2/core/types.hpp>
+#include "hash_table.h"
+
+/**
+ * struct TripletLayout
+ *
+ * Triplet points of all hash tables compiled for one window size. Points are stored as integer
+ * offsets relative to window top left corner, both as cv::Point and as linear offsets into image
+ * with given row stride (in elements), so reading triplet points of all tables in a window is
+ * only pointer-offset load from window origin.
+ */
+struct TripletLayout {
+public:
+    cv::Size windowSize;
+    size_t rowStride;
+    std::vector<cv::Point> c, p1, p2; // i-th element belongs to i-th hash table
+    std::vector<int> cOffsets, p1Offsets, p2Offsets;
+
+    // Constructors
+    TripletLayout() : rowStride(0) {}
+    TripletLayout(cv::Size windowSize, size_t rowStride, const std::vector<HashTable> &hashTables, const cv::Size &referencePointsGrid);
+
+    // Methods
+    bool isCompiledFor(cv::Size windowSize, size_t rowStride) const;
+    size_t size() const;
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TRIPLET_LAYOUT_H
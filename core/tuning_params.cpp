@@ -0,0 +1,73 @@
+#include "tuning_params.h"
+#include <cassert>
+
+bool TuningParams::dominates(const TuningParams &rhs) const {
+    // Configuration dominates other if it's not worse in any measure and better in at least one
+    return latency <= rhs.latency && recall >= rhs.recall && (latency < rhs.latency || recall > rhs.recall);
+}
+
+void TuningParams::write(cv::FileStorage &fs) const {
+    fs << "objectness" << "{"
+       << "step" << static_cast<int>(step)
+       << "minThreshold" << minThreshold
+       << "maxThreshold" << maxThreshold
+       << "}";
+
+    fs << "hasher" << "{"
+       << "hashTableCount" << static_cast<int>(hashTableCount)
+       << "histogramBinCount" << static_cast<int>(histogramBinCount)
+       << "maxTripletDistance" << static_cast<int>(maxTripletDistance)
+       << "minVotesPerTemplate" << minVotesPerTemplate
+       << "}";
+
+    fs << "latency" << latency;
+    fs << "recall" << recall;
+}
+
+void TuningParams::read(const cv::FileNode &node) {
+    int iStep, iHashTableCount, iHistogramBinCount, iMaxTripletDistance;
+    cv::FileNode objectnessNode = node["objectness"];
+    cv::FileNode hasherNode = node["hasher"];
+
+    // Checks
+    assert(!objectnessNode.empty());
+    assert(!hasherNode.empty());
+
+    // Objectness params
+    objectnessNode["step"] >> iStep;
+    objectnessNode["minThreshold"] >> minThreshold;
+    objectnessNode["maxThreshold"] >> maxThreshold;
+
+    // Hasher params
+    hasherNode["hashTableCount"] >> iHashTableCount;
+    hasherNode["histogramBinCount"] >> iHistogramBinCount;
+    hasherNode["maxTripletDistance"] >> iMaxTripletDistance;
+    hasherNode["minVotesPerTemplate"] >> minVotesPerTemplate;
+
+    // Measured results
+    node["latency"] >> latency;
+    node["recall"] >> recall;
+
+    // Check values
+    assert(iStep > 0);
+    assert(iHashTableCount > 0);
+    assert(iHistogramBinCount > 0);
+    assert(iMaxTripletDistance > 1);
+
+    step = static_cast<unsigned int>(iStep);
+    hashTableCount = static_cast<unsigned int>(iHashTableCount);
+    histogramBinCount = static_cast<unsigned int>(iHistogramBinCount);
+    maxTripletDistance = static_cast<unsigned int>(iMaxTripletDistance);
+}
+
+std::ostream &operator<<(std::ostream &os, const TuningParams &params) {
+    os << "step: " << params.step
+       << ", thresholds: <" << params.minThreshold << ", " << params.maxThreshold << ">"
+       << ", hashTableCount: " << params.hashTableCount
+       << ", histogramBinCount: " << params.histogramBinCount
+       << ", maxTripletDistance: " << params.maxTripletDistance
+       << ", minVotesPerTemplate: " << params.minVotesPerTemplate
+       << " => latency: " << params.latency << "s, recall: " << params.recall;
+
+    return os;
+}
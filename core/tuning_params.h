@@ -0,0 +1,47 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TUNING_PARAMS_H
+#define VSB_SEMESTRAL_PROJECT_TUNING_PARAMS_H
+
+#include <opencv2/core/persistence.hpp>
+#include <ostream>
+
+/**
+ * struct TuningParams
+ *
+ * One configuration of classifier parameters explored by AutoTuner, together with
+ * average detection latency and recall measured on validation scenes. Configurations
+ * are saved into and loaded from .yml files using objectness and hasher sections.
+ */
+struct TuningParams {
+public:
+    // Objectness params
+    unsigned int step;
+    float minThreshold;
+    float maxThreshold;
+
+    // Hasher params
+    unsigned int hashTableCount;
+    unsigned int histogramBinCount;
+    unsigned int maxTripletDistance;
+    int minVotesPerTemplate;
+
+    // Measured results
+    double latency; // Average detection time per scene [s]
+    float recall; // Ratio of found ground truth objects <0, 1>
+
+    // Constructors
+    TuningParams(unsigned int step = 5, float minThreshold = 0.01f, float maxThreshold = 0.1f, unsigned int hashTableCount = 100,
+                 unsigned int histogramBinCount = 5, unsigned int maxTripletDistance = 5, int minVotesPerTemplate = 3)
+        : step(step), minThreshold(minThreshold), maxThreshold(maxThreshold), hashTableCount(hashTableCount),
+          histogramBinCount(histogramBinCount), maxTripletDistance(maxTripletDistance),
+          minVotesPerTemplate(minVotesPerTemplate), latency(0), recall(0) {}
+
+    // Methods
+    bool dominates(const TuningParams &rhs) const;
+    void write(cv::FileStorage &fs) const;
+    void read(const cv::FileNode &node);
+
+    // Operators
+    friend std::ostream &operator<<(std::ostream &os, const TuningParams &params);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TUNING_PARAMS_H
@@ -0,0 +1,84 @@
+#include "viewpoint_graph.h"
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <algorithm>
+
+float ViewpointGraph::geodesicDistance(const cv::Matx33f &r1, const cv::Matx33f &r2) {
+    // trace(R1^T * R2) = 1 + 2cos(angle), trace of the product is sum of element-wise products
+    float trace = 0;
+    for (int i = 0; i < 9; i++) {
+        trace += r1.val[i] * r2.val[i];
+    }
+
+    return std::acos(std::max(-1.0f, std::min(1.0f, (trace - 1.0f) / 2.0f)));
+}
+
+void ViewpointGraph::build(const TemplateStore &store, uint k) {
+    // Checks
+    assert(!store.empty());
+
+    clear();
+    this->k = k;
+    const int count = static_cast<int>(store.size());
+
+    // Group handles of each object, only viewpoints of the same object are neighbours
+    std::map<int, std::vector<uint>> objects;
+    for (uint handle = 0; handle < store.size(); handle++) {
+        objects[store.metadata.objId[handle]].push_back(handle);
+    }
+
+    // Find k nearest viewpoints of each template
+    std::vector<std::vector<uint>> nearest(store.size());
+
+    #pragma omp parallel for
+    for (int handle = 0; handle < count; handle++) {
+        const std::vector<uint> &object = objects.at(store.metadata.objId[handle]);
+        const cv::Matx33f &r = store[handle].camRm2c;
+        std::vector<std::pair<float, uint>> distances;
+        distances.reserve(object.size());
+
+        for (auto &&other : object) {
+            if (other == static_cast<uint>(handle)) continue;
+            distances.push_back(std::make_pair(geodesicDistance(r, store[other].camRm2c), other));
+        }
+
+        const size_t n = std::min<size_t>(k, distances.size());
+        std::partial_sort(distances.begin(), distances.begin() + n, distances.end());
+        for (size_t i = 0; i < n; i++) {
+            nearest[handle].push_back(distances[i].second);
+        }
+    }
+
+    // Flatten neighbour lists
+    offsets.reserve(store.size() + 1);
+    for (auto &&list : nearest) {
+        offsets.push_back(static_cast<uint>(neighbours.size()));
+        neighbours.insert(neighbours.end(), list.begin(), list.end());
+    }
+    offsets.push_back(static_cast<uint>(neighbours.size()));
+}
+
+void ViewpointGraph::clear() {
+    k = 0;
+    offsets.clear();
+    neighbours.clear();
+}
+
+bool ViewpointGraph::empty() const {
+    return neighbours.empty();
+}
+
+size_t ViewpointGraph::size() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+}
+
+const uint *ViewpointGraph::begin(uint handle) const {
+    assert(handle < size());
+    return neighbours.data() + offsets[handle];
+}
+
+const uint *ViewpointGraph::end(uint handle) const {
+    assert(handle < size());
+    return neighbours.data() + offsets[handle + 1];
+}
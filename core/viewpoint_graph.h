@@ -0,0 +1,35 @@
+#ifndef VSB_SEMESTRAL_PROJECT_VIEWPOINT_GRAPH_H
+#define VSB_SEMESTRAL_PROJECT_VIEWPOINT_GRAPH_H
+
+#include <vector>
+#include "template_store.h"
+
+/**
+ * struct ViewpointGraph
+ *
+ * Precomputed k nearest viewpoints of each template in TemplateStore. Neighbours are templates
+ * of the same object sorted by rotation geodesic distance of their camRm2c (ASC). Neighbours of
+ * all templates are stored in one array, neighbours of template with handle i start at offsets[i].
+ */
+struct ViewpointGraph {
+public:
+    uint k;
+    std::vector<uint> offsets; // offsets[i] is first neighbour of handle i, offsets[size] is end
+    std::vector<uint> neighbours;
+
+    // Constructors
+    ViewpointGraph() : k(0) {}
+
+    // Methods
+    void build(const TemplateStore &store, uint k);
+    void clear();
+    bool empty() const;
+    size_t size() const; // Number of templates in graph
+    const uint *begin(uint handle) const;
+    const uint *end(uint handle) const;
+
+    // Angle of rotation between two viewpoints [rad]
+    static float geodesicDistance(const cv::Matx33f &r1, const cv::Matx33f &r2);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_VIEWPOINT_GRAPH_H
@@ -11,12 +11,14 @@ public:
     int width;
     int height;
     unsigned int edgels;
-    std::vector<Template *> candidates;
+    float depth; // Mean depth (mm) of valid scene pixels in central half of window, whole window if centre has none (0 if there are none)
+    int refineRadius; // Radius around window location, where matching refines template position (coalesced windows)
+    std::vector<uint> candidates; // Handles of candidate templates in TemplateStore
 
     // Constructors
-    Window(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
-    Window(int x, int y, int width, int height, unsigned int edgels) : x(x), y(y), width(width), height(height), edgels(edgels) {}
-    Window(int x, int y, int width, int height, std::vector<Template *> candidates, unsigned int edgels) : x(x), y(y), width(width), height(height), candidates(candidates), edgels(edgels) {}
+    Window(int x, int y, int width, int height) : x(x), y(y), width(width), height(height), edgels(0), depth(0), refineRadius(0) {}
+    Window(int x, int y, int width, int height, unsigned int edgels) : x(x), y(y), width(width), height(height), edgels(edgels), depth(0), refineRadius(0) {}
+    Window(int x, int y, int width, int height, std::vector<uint> candidates, unsigned int edgels) : x(x), y(y), width(width), height(height), candidates(candidates), edgels(edgels), depth(0), refineRadius(0) {}
 
     // Methods
     cv::Point tl();
@@ -25,7 +27,6 @@ public:
     cv::Point br();
     cv::Size size();
     bool hasCandidates();
-    void pushUnique(Template *t, unsigned int N = 100, int v = 3);
     unsigned long candidatesSize();
 
     // Friends
@@ -5,21 +5,51 @@
 #include "utils/timer.h"
 #include "objdetect/hasher.h"
 #include "objdetect/classifier.h"
+#include "utils/auto_tuner.h"
+#include "utils/config_parser.h"
 
-int main() {
-    // Init classifier
-    const std::vector<std::string> tplNames = { "02", "25", "29", "30" };
-    Classifier classifier("data/", tplNames, "scene_01/", "0000.png");
+int main(int argc, char **argv) {
+    // Init classifier from config [<config.yml>, data/config.yml by default]
+    Classifier classifier;
+    ConfigParser config;
+    if (!config.parse(argc > 1 ? argv[1] : "data/config.yml", classifier)) {
+        return 1;
+    }
 
-    // Init indices
-    std::unique_ptr<std::vector<int>> indices { new std::vector<int>() };
-    const int indiciesDataSize = 14;
-    int indiciesData[] = { 0, 20, 25, 23, 120, 250, 774, 998, 1100, 400, 478, 1095, 1015, 72 };
-    std::copy(&indiciesData[0], &indiciesData[indiciesDataSize], std::back_inserter(*indices));
+    // Auto tune classifier params on validation scenes [<config.yml> tune <output.yml>]
+    if (argc > 2 && std::string(argv[2]) == "tune") {
+#ifndef NDEBUG
+        // Debug visualizations wait for key press in every detection, which would stall tuning and skew latency
+        std::cerr << "Auto tuning requires release build (-DNDEBUG)" << std::endl;
+        return 1;
+#endif
+        AutoTuner tuner;
+        std::vector<TuningParams> front;
+        tuner.tune(classifier, front);
+        tuner.save(argc > 3 ? argv[3] : "data/tuning.yml", front);
+        return 0;
+    }
+
+    // Load tuned classifier params [<config.yml> tuned <tuning.yml> <index>]
+    if (argc > 3 && std::string(argv[2]) == "tuned") {
+        AutoTuner::apply(AutoTuner::load(argv[3], argc > 4 ? std::stoi(argv[4]) : -1), classifier);
+    }
+
+    // Classify sequence of scenes with frame to frame tracking [<config.yml> sequence <first> <count>]
+    if (argc > 4 && std::string(argv[2]) == "sequence") {
+        std::vector<std::string> sceneNames;
+        for (int i = std::stoi(argv[3]), end = i + std::stoi(argv[4]); i < end; i++) {
+            std::stringstream ss;
+            ss << std::setw(4) << std::setfill('0') << i << ".png";
+            sceneNames.push_back(ss.str());
+        }
+
+        classifier.classifySequence(sceneNames);
+        return 0;
+    }
 
     // Run classifier
-//    classifier.classify();
-    classifier.classifyTest(indices);
+    classifier.classify();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -3,9 +3,9 @@
 #include "../utils/timer.h"
 
 Classifier::Classifier(std::string basePath, std::vector<std::string> templateFolders, std::string scenePath, std::string sceneName) {
-    // Init properties
+    // Init properties, template folders can be set later (e.g. from config)
     setBasePath(basePath);
-    setTemplateFolders(templateFolders);
+    this->templateFolders = templateFolders;
     setScenePath(scenePath);
     setSceneName(sceneName);
 
@@ -39,31 +39,68 @@ void Classifier::parseTemplates() {
 
     // Parse
     std::cout << "Parsing... " << std::endl;
-    parser.parse(templateGroups);
+    parser.parse(templateStore, templateGroups, hueQuantizer);
     assert(templateGroups.size() > 0);
+
+    // Surface normals of templates are estimated only once, shared by hashing and matcher normal test
+    if (normalEstimator.isPlaneFit()) {
+        #pragma omp parallel for
+        for (int i = 0; i < static_cast<int>(templateStore.size()); i++) {
+            Template &t = templateStore[i];
+            normalEstimator.estimate(t.srcDepth, t.srcNormals);
+        }
+    }
+
+    // Feature points used in template matching are selected right away
+    if (templateMatcher.isFeatureMatching()) {
+        templateMatcher.train(templateStore, gradientResponse, hueQuantizer);
+    }
     std::cout << "DONE! " << templateGroups.size() << " template groups parsed" << std::endl << std::endl;
 }
 
 void Classifier::extractMinEdgels() {
     // Checks
-    assert(templateGroups.size() > 0);
+    assert(templateStore.size() > 0);
 
     // Extract min edgels
     std::cout << "Extracting min edgels... " << std::endl;
-    setMinEdgels(objectness.extractMinEdgels(templateGroups));
+    setMinEdgels(objectness.extractMinEdgels(templateStore));
+
+    // Edgels of templates changed, router signatures of already trained indices are refreshed
+    for (auto &&index : hashIndices) {
+        index.computeSignature(templateStore);
+    }
     std::cout << "DONE! " << minEdgels << " minimum found" <<std::endl << std::endl;
 }
 
 void Classifier::trainHashTables() {
     // Checks
-    assert(templateGroups.size() > 0);
+    assert(templateStore.size() > 0);
 
-    // Train hash tables
+    // Drop indices from previous training, create one index per object or one for whole catalog
     std::cout << "Training hash tables... " << std::endl;
     Timer t;
-    hasher.train(templateGroups, hashTables);
-    assert(hashTables.size() > 0);
-    std::cout << "DONE! took: " << t.elapsed() << "s, " << hashTables.size() << " hash tables generated" <<std::endl << std::endl;
+    hashIndices.clear();
+    if (hasher.isPerObjectIndices()) {
+        for (auto &&group : templateGroups) {
+            // Templates of each group are pushed to the store at once, so they form continuous range of handles
+            assert(!group.templates.empty());
+            assert(group.templates.back() - group.templates.front() + 1 == group.templates.size());
+            hashIndices.push_back(HashIndex(templateStore[group.templates.front()].objId, group.templates.front(), group.templates.back() + 1));
+        }
+    } else {
+        hashIndices.push_back(HashIndex(-1, 0, static_cast<uint>(templateStore.size())));
+    }
+
+    // Train hash tables of all indices, triplets are shared by indices
+    hasher.train(templateStore, hashIndices);
+    size_t tablesCount = 0;
+    for (auto &&index : hashIndices) {
+        assert(index.hashTables.size() > 0);
+        tablesCount += index.hashTables.size();
+        std::cout << "  |_ " << index << std::endl;
+    }
+    std::cout << "DONE! took: " << t.elapsed() << "s, " << tablesCount << " hash tables generated" <<std::endl << std::endl;
 }
 
 void Classifier::loadScene() {
@@ -79,12 +116,34 @@ void Classifier::loadScene() {
     setScene(cv::imread(basePath + scenePath + "rgb/" + sceneName, CV_LOAD_IMAGE_COLOR));
     setSceneDepth(cv::imread(basePath + scenePath + "depth/" + sceneName, CV_LOAD_IMAGE_UNCHANGED));
 
-    // Convert and normalize
+    // Convert and normalize, depth holes are filled and invalid depth masked before normalization
     cv::cvtColor(scene, sceneGrayscale, CV_BGR2GRAY);
     sceneGrayscale.convertTo(sceneGrayscale, CV_32F, 1.0f / 255.0f);
     sceneDepth.convertTo(sceneDepth, CV_32F);
+    depthPreprocessor.preprocess(sceneDepth, sceneDepthValid);
     sceneDepth.convertTo(sceneDepthNormalized, CV_32F, 1.0f / 65536.0f);
 
+    // Normals of whole frame, shared by hashing and matching
+    if (normalEstimator.isPlaneFit()) {
+        normalEstimator.estimate(sceneDepth, sceneDepthValid, sceneNormals);
+    } else {
+        sceneNormals.release();
+    }
+
+    // Gradient response maps used in gradient test of matching
+    if (gradientResponse.isEnabled()) {
+        gradientResponse.computeResponseMaps(sceneGrayscale, sceneResponseMaps);
+    } else {
+        sceneResponseMaps.clear();
+    }
+
+    // Quantized hue used in color test of matching, templates are quantized same way at load time
+    if (hueQuantizer.isEnabled()) {
+        hueQuantizer.quantize(scene, sceneHue);
+    } else {
+        sceneHue.release();
+    }
+
     // Check if conversion went ok
     assert(!sceneGrayscale.empty());
     assert(!sceneDepthNormalized.empty());
@@ -92,6 +151,7 @@ void Classifier::loadScene() {
     assert(sceneGrayscale.type() == 5); // CV_32FC1
     assert(sceneDepth.type() == 5); // CV_32FC1
     assert(sceneDepthNormalized.type() == 5); // CV_32FC1
+    assert(sceneDepthValid.type() == 0); // CV_8UC1
 
     std::cout << "DONE!" << std::endl << std::endl;
 }
@@ -100,9 +160,10 @@ void Classifier::detectObjectness() {
     // Checks
     assert(minEdgels[0] > 0 && minEdgels[1] > 0 && minEdgels[2] > 0);
 
-    // Objectness detection
+    // Objectness detection, drop windows from previous scene first
     std::cout << "Objectness detection started... " << std::endl;
     Timer t;
+    windows.clear();
     objectness.objectness(sceneGrayscale, scene, sceneDepthNormalized, windows, minEdgels);
     std::cout << "  |_ Windows classified as containing object extracted: " << windows.size() << std::endl;
     std::cout << "DONE! took: " << t.elapsed() << "s" << std::endl << std::endl;
@@ -110,12 +171,18 @@ void Classifier::detectObjectness() {
 
 void Classifier::verifyTemplateCandidates() {
     // Checks
-    assert(hashTables.size() > 0);
+    assert(hashIndices.size() > 0);
+
+    // Nothing to verify if objectness didn't find any windows
+    if (windows.empty()) {
+        return;
+    }
 
     // Verification started
     std::cout << "Verification of template candidates, using trained HashTables started... " << std::endl;
     Timer t;
-    hasher.verifyTemplateCandidates(sceneDepth, hashTables, windows);
+    hasher.verifyTemplateCandidates(sceneDepth, sceneDepthValid, sceneNormals, templateStore, hashIndices, windows,
+                                    objectness.getMatchThresholdFactor());
     std::cout << "DONE! took: " << t.elapsed() << "s" << std::endl << std::endl;
 
 #ifndef NDEBUG
@@ -132,83 +199,136 @@ void Classifier::verifyTemplateCandidates() {
 }
 
 void Classifier::matchTemplates() {
+    // Drop matches from previous scene
+    matches.clear();
+    matchBBs.clear();
 
-}
-
-void Classifier::classify() {
-    /// Hypothesis generation
-    // Load scene images
-    loadScene();
-
-    // Parse templates
-    parseTemplates();
+    // Match candidates in each window
+    std::cout << "Template matching started... " << std::endl;
+    Timer t;
 
-    // Extract min edgels
-    extractMinEdgels();
+    // Dense normalized cross correlation over whole templates at window locations
+    if (!templateMatcher.isFeatureMatching()) {
+        matchBBs = matcher_deprecated::matchTemplate(sceneGrayscale, templateStore, windows);
+        std::cout << "DONE! took: " << t.elapsed() << "s, " << matchBBs.size() << " objects matched" << std::endl << std::endl;
+        return;
+    }
 
-    // Train hash tables
-    trainHashTables();
+    templateMatcher.match(scene, sceneGrayscale, sceneDepth, sceneNormals, sceneResponseMaps, sceneHue, templateStore, windows, matches);
 
-    /// Hypothesis verification
-    // Start stopwatch
-    Timer tTotal;
+    // Suppress overlapping matches, bounding boxes are scaled same as matched templates
+    if (!matches.empty()) {
+        std::vector<cv::Rect> bBs;
+        std::vector<float> scores;
+        for (auto &&match : matches) {
+            const Template &tpl = templateStore[match.handle];
+            bBs.push_back(cv::Rect(match.tl.x, match.tl.y, cvRound(tpl.objBB.width * match.scale), cvRound(tpl.objBB.height * match.scale)));
+            scores.push_back(match.score);
+        }
 
-    // Objectness detection
-    detectObjectness();
+        matchBBs = matcher_deprecated::nonMaximaSuppression(bBs, scores);
+    }
 
-    // Verification and filtering of template candidates
-    verifyTemplateCandidates();
+    std::cout << "DONE! took: " << t.elapsed() << "s, " << matchBBs.size() << " objects matched" << std::endl << std::endl;
+}
 
-    // Template TemplateMatcher
-    Timer tMatching;
-    std::vector<cv::Rect> matchBBs = matcher_deprecated::matchTemplate(sceneGrayscale, windows);
+void Classifier::showMatches() {
+    // Draw matched bounding boxes
     cv::Mat sceneCopy = scene.clone();
     for (auto &&bB : matchBBs) {
         cv::rectangle(sceneCopy, cv::Point(bB.x, bB.y), cv::Point(bB.x + bB.width, bB.y + bB.height), cv::Scalar(0, 255, 0));
     }
 
     // Show matched template results
-    std::cout << "Classification took: " << tTotal.elapsed() << "s" << std::endl;
     cv::imshow("Match template result", sceneCopy);
     cv::waitKey(0);
 }
 
-void Classifier::classifyTest(std::unique_ptr<std::vector<int>> &indices) {
-    /// Hypothesis generation
-    // Load scene images
-    loadScene();
-
-    // Parse templates with specific indices
-    parser.setIndices(indices);
-    parseTemplates();
+void Classifier::train() {
+    // Parse templates, already parsed templates are reused
+    if (templateStore.empty()) {
+        parseTemplates();
+    }
 
     // Extract min edgels
     extractMinEdgels();
 
     // Train hash tables
     trainHashTables();
+}
 
-    /// Hypothesis verification
-    // Start stopwatch
-    Timer t;
-
+void Classifier::detect() {
     // Objectness detection
     detectObjectness();
 
     // Verification and filtering of template candidates
     verifyTemplateCandidates();
 
-    // Template TemplateMatcher
-    std::vector<cv::Rect> matchBBs = matcher_deprecated::matchTemplate(sceneGrayscale, windows);
-    cv::Mat sceneCopy = scene.clone();
-    for (auto &&bB : matchBBs) {
-        cv::rectangle(sceneCopy, cv::Point(bB.x, bB.y), cv::Point(bB.x + bB.width, bB.y + bB.height), cv::Scalar(0, 255, 0));
+    // Template matching
+    matchTemplates();
+}
+
+void Classifier::track() {
+    // Full detection on first frame, every redetectInterval frames or on track loss
+    if (tracker.needsDetection()) {
+        detect();
+        tracker.update(templateStore, matches, matchBBs, true);
+        return;
     }
 
+    // Search only around previous matches, objectness and hashing are skipped
+    windows.clear();
+    tracker.seedWindows(templateStore, templateMatcher.getViewpointGraph(), windows);
+    matchTemplates();
+    tracker.update(templateStore, matches, matchBBs, false);
+}
+
+void Classifier::classify() {
+    /// Hypothesis generation
+    // Load scene images
+    loadScene();
+
+    // Parse templates, extract min edgels and train hash tables
+    train();
+
+    /// Hypothesis verification
+    // Start stopwatch
+    Timer tTotal;
+
+    // Objectness, verification of template candidates and template matching
+    detect();
+
     // Show matched template results
-    std::cout << "Classification took: " << t.elapsed() << "s" << std::endl;
-    cv::imshow("Match template result", sceneCopy);
-    cv::waitKey(0);
+    std::cout << "Classification took: " << tTotal.elapsed() << "s" << std::endl;
+    showMatches();
+}
+
+void Classifier::classifySequence(const std::vector<std::string> &sceneNames) {
+    // Checks
+    assert(!sceneNames.empty());
+
+    // Train once for the whole sequence (training doesn't need the scene), tracking starts with full detection
+    train();
+    tracker.reset();
+
+    Timer tTotal;
+    for (auto &&sceneName : sceneNames) {
+        setSceneName(sceneName);
+        loadScene();
+
+        Timer t;
+        track();
+        std::cout << "Frame " << sceneName << " took: " << t.elapsed() << "s, " << matchBBs.size() << " objects matched" << std::endl;
+    }
+
+    std::cout << "Classification of " << sceneNames.size() << " frames took: " << tTotal.elapsed() << "s" << std::endl;
+    showMatches();
+}
+
+void Classifier::classifyTest(std::unique_ptr<std::vector<int>> &indices) {
+    // Parse templates with specific indices
+    parser.setIndices(indices);
+    classify();
 }
 
 // Getters and setters
@@ -236,8 +356,8 @@ const cv::Mat &Classifier::getSceneDepth() const {
     return sceneDepth;
 }
 
-const std::vector<HashTable> &Classifier::getHashTables() const {
-    return hashTables;
+const std::vector<HashIndex> &Classifier::getHashIndices() const {
+    return hashIndices;
 }
 
 const std::string &Classifier::getSceneName() const {
@@ -248,10 +368,30 @@ const cv::Mat &Classifier::getSceneDepthNormalized() const {
     return sceneDepthNormalized;
 }
 
+const cv::Mat &Classifier::getSceneDepthValid() const {
+    return sceneDepthValid;
+}
+
+const cv::Mat &Classifier::getSceneNormals() const {
+    return sceneNormals;
+}
+
+const ResponseMaps &Classifier::getSceneResponseMaps() const {
+    return sceneResponseMaps;
+}
+
+const cv::Mat &Classifier::getSceneHue() const {
+    return sceneHue;
+}
+
 const cv::Mat &Classifier::getSceneGrayscale() const {
     return sceneGrayscale;
 }
 
+const TemplateStore &Classifier::getTemplateStore() const {
+    return templateStore;
+}
+
 const std::vector<TemplateGroup> &Classifier::getTemplateGroups() const {
     return templateGroups;
 }
@@ -264,6 +404,10 @@ const std::vector<TemplateMatch> &Classifier::getMatches() const {
     return matches;
 }
 
+const std::vector<cv::Rect> &Classifier::getMatchBBs() const {
+    return matchBBs;
+}
+
 void Classifier::setMinEdgels(const cv::Vec3f &minEdgels) {
     assert(minEdgels[0] > 0 && minEdgels[1] > 0 && minEdgels[2] > 0);
     this->minEdgels = minEdgels;
@@ -291,6 +435,23 @@ void Classifier::setSceneDepthNormalized(const cv::Mat &sceneDepthNormalized) {
     this->sceneDepthNormalized = sceneDepthNormalized;
 }
 
+void Classifier::setSceneDepthValid(const cv::Mat &sceneDepthValid) {
+    assert(!sceneDepthValid.empty());
+    this->sceneDepthValid = sceneDepthValid;
+}
+
+void Classifier::setSceneNormals(const cv::Mat &sceneNormals) {
+    this->sceneNormals = sceneNormals;
+}
+
+void Classifier::setSceneResponseMaps(const ResponseMaps &sceneResponseMaps) {
+    this->sceneResponseMaps = sceneResponseMaps;
+}
+
+void Classifier::setSceneHue(const cv::Mat &sceneHue) {
+    this->sceneHue = sceneHue;
+}
+
 void Classifier::setTemplateGroups(const std::vector<TemplateGroup> &templateGroups) {
     assert(templateGroups.size() > 0);
     this->templateGroups = templateGroups;
@@ -306,9 +467,9 @@ void Classifier::setScene(const cv::Mat &scene) {
     this->scene = scene;
 }
 
-void Classifier::setHashTables(const std::vector<HashTable> &hashTables) {
-    assert(hashTables.size() > 0);
-    this->hashTables = hashTables;
+void Classifier::setHashIndices(const std::vector<HashIndex> &hashIndices) {
+    assert(hashIndices.size() > 0);
+    this->hashIndices = hashIndices;
 }
 
 void Classifier::setSceneName(const std::string &sceneName) {
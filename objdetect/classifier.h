@@ -2,13 +2,20 @@
 #define VSB_SEMESTRAL_PROJECT_CLASSIFICATOR_H
 
 #include "../core/template_group.h"
+#include "../core/template_store.h"
 #include "../core/template_match.h"
 #include "../core/hash_table.h"
+#include "../core/hash_index.h"
 #include "../utils/template_parser.h"
 #include "hasher.h"
 #include "objectness.h"
 #include "../core/window.h"
 #include "template_matcher.h"
+#include "tracker.h"
+#include "depth_preprocessor.h"
+#include "normal_estimator.h"
+#include "gradient_response.h"
+#include "hue_quantizer.h"
 
 /**
  * class Classifier
@@ -30,32 +37,51 @@ private:
     cv::Mat sceneGrayscale;
     cv::Mat sceneDepth;
     cv::Mat sceneDepthNormalized;
+    cv::Mat sceneDepthValid; // CV_8U, 1 = pixel has valid depth
+    cv::Mat sceneNormals; // CV_32FC3, empty if normals aren't estimated per frame
+    ResponseMaps sceneResponseMaps; // Linearized gradient response maps, empty if not computed
+    cv::Mat sceneHue; // Quantized hue CV_8UC1, empty if color isn't quantized
 
+    TemplateStore templateStore;
     std::vector<TemplateGroup> templateGroups;
-    std::vector<HashTable> hashTables;
+    std::vector<HashIndex> hashIndices;
     std::vector<Window> windows;
     std::vector<TemplateMatch> matches;
+    std::vector<cv::Rect> matchBBs;
 
     // Methods
     void parseTemplates();
-    void loadScene();
     void extractMinEdgels();
     void trainHashTables();
     void detectObjectness();
     void verifyTemplateCandidates();
     void matchTemplates();
+    void showMatches();
+
+    // Friends
+    friend class AutoTuner;
 public:
     // Classifiers
     TemplateParser parser;
+    DepthPreprocessor depthPreprocessor;
+    NormalEstimator normalEstimator;
+    GradientResponse gradientResponse;
+    HueQuantizer hueQuantizer;
     Objectness objectness;
     Hasher hasher;
     TemplateMatcher templateMatcher;
+    Tracker tracker;
 
     // Constructors
     Classifier(std::string basePath = "data/", std::vector<std::string> templateFolders = {}, std::string scenePath = "scene_01/", std::string sceneName = "0000.png");
 
     // Methods
+    void train();
+    void loadScene();
+    void detect();
+    void track();
     void classify();
+    void classifySequence(const std::vector<std::string> &sceneNames);
     void classifyTest(std::unique_ptr<std::vector<int>> &indices);
 
     // Getters
@@ -68,10 +94,16 @@ public:
     const cv::Mat &getSceneGrayscale() const;
     const cv::Mat &getSceneDepth() const;
     const cv::Mat &getSceneDepthNormalized() const;
+    const cv::Mat &getSceneDepthValid() const;
+    const cv::Mat &getSceneNormals() const;
+    const ResponseMaps &getSceneResponseMaps() const;
+    const cv::Mat &getSceneHue() const;
+    const TemplateStore &getTemplateStore() const;
     const std::vector<TemplateGroup> &getTemplateGroups() const;
-    const std::vector<HashTable> &getHashTables() const;
+    const std::vector<HashIndex> &getHashIndices() const;
     const std::vector<Window> &getWindows() const;
     const std::vector<TemplateMatch> &getMatches() const;
+    const std::vector<cv::Rect> &getMatchBBs() const;
 
     // Setters
     void setMinEdgels(const cv::Vec3f &minEdgels);
@@ -83,8 +115,12 @@ public:
     void setSceneGrayscale(const cv::Mat &sceneGrayscale);
     void setSceneDepth(const cv::Mat &sceneDepth);
     void setSceneDepthNormalized(const cv::Mat &sceneDepthNormalized);
+    void setSceneDepthValid(const cv::Mat &sceneDepthValid);
+    void setSceneNormals(const cv::Mat &sceneNormals);
+    void setSceneResponseMaps(const ResponseMaps &sceneResponseMaps);
+    void setSceneHue(const cv::Mat &sceneHue);
     void setTemplateGroups(const std::vector<TemplateGroup> &templateGroups);
-    void setHashTables(const std::vector<HashTable> &hashTables);
+    void setHashIndices(const std::vector<HashIndex> &hashIndices);
     void setWindows(const std::vector<Window> &windows);
     void setMatches(const std::vector<TemplateMatch> &matches);
 };
@@ -0,0 +1,152 @@
+#include "depth_preprocessor.h"
+#include <cassert>
+#include <cfloat>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+void DepthPreprocessor::fillHoles(cv::Mat &depth, cv::Mat &valid) {
+    // Sum of valid depths and number of valid pixels in neighbourhood of each pixel (box filters are vectorized)
+    const int size = 2 * maxHoleSize + 1;
+    cv::Mat validF, depthSum, validSum;
+    valid.convertTo(validF, CV_32F);
+    cv::boxFilter(depth, depthSum, CV_32F, cv::Size(size, size), cv::Point(-1, -1), false);
+    cv::boxFilter(validF, validSum, CV_32F, cv::Size(size, size), cv::Point(-1, -1), false);
+
+    // Invalid pixels with any valid neighbour get their mean depth (invalid pixels have zero depth, so they don't add to sum)
+    cv::Mat mean, fill;
+    cv::divide(depthSum, cv::max(validSum, 1.0f), mean);
+    cv::compare(validSum, 0, fill, cv::CMP_GT);
+    cv::bitwise_and(fill, valid == 0, fill);
+
+    // Holes on depth discontinuities are not filled, their mean would mix foreground and background depth
+    if (maxFillSpread > 0) {
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(size, size));
+        cv::Mat depthMin, depthMax, spread;
+        cv::Mat depthValidMin = depth.clone();
+        depthValidMin.setTo(FLT_MAX, valid == 0);
+        cv::erode(depthValidMin, depthMin, kernel);
+        cv::dilate(depth, depthMax, kernel);
+
+        cv::subtract(depthMax, depthMin, spread);
+        cv::bitwise_and(fill, spread <= maxFillSpread, fill);
+    }
+
+    mean.copyTo(depth, fill);
+    valid.setTo(1, fill);
+}
+
+void DepthPreprocessor::medianValid(cv::Mat &depth, const cv::Mat &valid) {
+    // Median of valid pixels in medianSize neighbourhood of each valid pixel, pixels without depth neither
+    // take part in median nor get value from it (cv::medianBlur would pull depth of object borders towards zero)
+    const int rad = static_cast<int>(medianSize) / 2;
+    cv::Mat filtered = depth.clone();
+
+    #pragma omp parallel for
+    for (int r = 0; r < depth.rows; r++) {
+        const uchar *pValid = valid.ptr<uchar>(r);
+        float *pFiltered = filtered.ptr<float>(r);
+        float values[25];
+
+        for (int c = 0; c < depth.cols; c++) {
+            if (!pValid[c]) continue;
+
+            int count = 0;
+            for (int y = std::max(0, r - rad); y <= std::min(depth.rows - 1, r + rad); y++) {
+                const float *pDepth = depth.ptr<float>(y);
+                const uchar *pNeighbourValid = valid.ptr<uchar>(y);
+
+                for (int x = std::max(0, c - rad); x <= std::min(depth.cols - 1, c + rad); x++) {
+                    if (pNeighbourValid[x]) values[count++] = pDepth[x];
+                }
+            }
+
+            std::nth_element(values, values + count / 2, values + count);
+            pFiltered[c] = values[count / 2];
+        }
+    }
+
+    depth = filtered;
+}
+
+void DepthPreprocessor::preprocess(cv::Mat &depth, cv::Mat &valid) {
+    // Checks
+    assert(!depth.empty());
+    assert(depth.type() == 5); // CV_32FC1
+
+    // Sensor reports missing depth as zero
+    cv::compare(depth, 0, valid, cv::CMP_GT);
+    valid.convertTo(valid, CV_8U, 1.0 / 255.0);
+
+    if (maxHoleSize > 0) {
+        fillHoles(depth, valid);
+    }
+
+    // Smoothing after hole filling, pixels still without depth are restored to zero afterwards so they stay invalid
+    if (medianSize > 0) {
+        medianValid(depth, valid);
+    }
+
+    if (bilateralDiameter > 0) {
+        cv::Mat filtered;
+        cv::bilateralFilter(depth, filtered, bilateralDiameter, bilateralSigmaDepth, bilateralSigmaSpace);
+        depth = filtered;
+    }
+
+    if (medianSize > 0 || bilateralDiameter > 0) {
+        depth.setTo(0, valid == 0);
+    }
+}
+
+// Getters and setters
+unsigned int DepthPreprocessor::getMaxHoleSize() const {
+    return maxHoleSize;
+}
+
+float DepthPreprocessor::getMaxFillSpread() const {
+    return maxFillSpread;
+}
+
+unsigned int DepthPreprocessor::getMedianSize() const {
+    return medianSize;
+}
+
+unsigned int DepthPreprocessor::getBilateralDiameter() const {
+    return bilateralDiameter;
+}
+
+float DepthPreprocessor::getBilateralSigmaDepth() const {
+    return bilateralSigmaDepth;
+}
+
+float DepthPreprocessor::getBilateralSigmaSpace() const {
+    return bilateralSigmaSpace;
+}
+
+void DepthPreprocessor::setMaxHoleSize(unsigned int maxHoleSize) {
+    this->maxHoleSize = maxHoleSize;
+}
+
+void DepthPreprocessor::setMaxFillSpread(float maxFillSpread) {
+    assert(maxFillSpread >= 0);
+    this->maxFillSpread = maxFillSpread;
+}
+
+void DepthPreprocessor::setMedianSize(unsigned int medianSize) {
+    // Median of valid pixels is collected into fixed buffer of 5x5 values
+    assert(medianSize == 0 || medianSize == 3 || medianSize == 5);
+    this->medianSize = medianSize;
+}
+
+void DepthPreprocessor::setBilateralDiameter(unsigned int bilateralDiameter) {
+    this->bilateralDiameter = bilateralDiameter;
+}
+
+void DepthPreprocessor::setBilateralSigmaDepth(float bilateralSigmaDepth) {
+    assert(bilateralSigmaDepth > 0);
+    this->bilateralSigmaDepth = bilateralSigmaDepth;
+}
+
+void DepthPreprocessor::setBilateralSigmaSpace(float bilateralSigmaSpace) {
+    assert(bilateralSigmaSpace > 0);
+    this->bilateralSigmaSpace = bilateralSigmaSpace;
+}
@@ -0,0 +1,53 @@
+#ifndef VSB_SEMESTRAL_PROJECT_DEPTH_PREPROCESSOR_H
+#define VSB_SEMESTRAL_PROJECT_DEPTH_PREPROCESSOR_H
+
+#include <opencv2/core/mat.hpp>
+
+/**
+ * class DepthPreprocessor
+ *
+ * Runs once per frame on raw scene depth (CV_32F) before detection. Holes (zero depth) up to
+ * maxHoleSize pixels from valid depth are filled with mean of valid depths around them (normalized
+ * box filter), unless valid depths around them spread over more than maxFillSpread (hole lies on depth
+ * discontinuity). Depth can be then smoothed by median of valid pixels or bilateral filter. Pixels which
+ * remain without depth are marked in valid mask (CV_8U, 1 = valid depth), so later stages can skip them.
+ */
+class DepthPreprocessor {
+private:
+    unsigned int maxHoleSize; // Max distance of filled pixels from valid depth, 0 = no hole filling [2]
+    float maxFillSpread; // Max difference of valid depths around filled pixel in depth units, 0 = no limit [100]
+    unsigned int medianSize; // Aperture of median filter (3 or 5), 0 = no median filter [0]
+    unsigned int bilateralDiameter; // Diameter of bilateral filter, 0 = no bilateral filter [0]
+    float bilateralSigmaDepth; // Range sigma of bilateral filter in depth units [20]
+    float bilateralSigmaSpace; // Spatial sigma of bilateral filter in pixels [3]
+
+    void fillHoles(cv::Mat &depth, cv::Mat &valid);
+    void medianValid(cv::Mat &depth, const cv::Mat &valid);
+public:
+    // Constructors
+    DepthPreprocessor(unsigned int maxHoleSize = 2, float maxFillSpread = 100.0f, unsigned int medianSize = 0,
+                      unsigned int bilateralDiameter = 0, float bilateralSigmaDepth = 20.0f, float bilateralSigmaSpace = 3.0f)
+        : maxHoleSize(maxHoleSize), maxFillSpread(maxFillSpread), medianSize(medianSize), bilateralDiameter(bilateralDiameter),
+          bilateralSigmaDepth(bilateralSigmaDepth), bilateralSigmaSpace(bilateralSigmaSpace) {}
+
+    // Methods
+    void preprocess(cv::Mat &depth, cv::Mat &valid);
+
+    // Getters
+    unsigned int getMaxHoleSize() const;
+    float getMaxFillSpread() const;
+    unsigned int getMedianSize() const;
+    unsigned int getBilateralDiameter() const;
+    float getBilateralSigmaDepth() const;
+    float getBilateralSigmaSpace() const;
+
+    // Setters
+    void setMaxHoleSize(unsigned int maxHoleSize);
+    void setMaxFillSpread(float maxFillSpread);
+    void setMedianSize(unsigned int medianSize);
+    void setBilateralDiameter(unsigned int bilateralDiameter);
+    void setBilateralSigmaDepth(float bilateralSigmaDepth);
+    void setBilateralSigmaSpace(float bilateralSigmaSpace);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_DEPTH_PREPROCESSOR_H
@@ -0,0 +1,159 @@
+#include "gradient_response.h"
+#include <cassert>
+#include <cmath>
+#include <opencv2/opencv.hpp>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+const int GradientResponse::ORIENTATIONS = 8;
+const uchar GradientResponse::MAX_RESPONSE = 4;
+
+void GradientResponse::quantize(const cv::Mat &src, cv::Mat &quantized) {
+    // Checks
+    assert(!src.empty());
+    assert(src.type() == 5); // CV_32FC1
+
+    cv::Mat dx, dy;
+    cv::Sobel(src, dx, CV_32F, 1, 0, 3);
+    cv::Sobel(src, dy, CV_32F, 0, 1, 3);
+    quantized = cv::Mat::zeros(src.rows, src.cols, CV_8UC1);
+
+    // Orientation modulo 180 deg quantized into ORIENTATIONS bins, only strong gradients are kept
+    const float minMagnitudeSqr = minMagnitude * minMagnitude;
+    #pragma omp parallel for
+    for (int y = 0; y < src.rows; y++) {
+        const float *pDx = dx.ptr<float>(y), *pDy = dy.ptr<float>(y);
+        uchar *pQuantized = quantized.ptr<uchar>(y);
+
+        for (int x = 0; x < src.cols; x++) {
+            if (pDx[x] * pDx[x] + pDy[x] * pDy[x] < minMagnitudeSqr) continue;
+
+            float angle = std::atan2(pDy[x], pDx[x]) * static_cast<float>(180.0 / CV_PI);
+            if (angle < 0) angle += 180.0f;
+            const int bin = static_cast<int>(angle * ORIENTATIONS / 180.0f) % ORIENTATIONS;
+            pQuantized[x] = static_cast<uchar>(1 << bin);
+        }
+    }
+}
+
+void GradientResponse::spread(const cv::Mat &quantized, cv::Mat &spreaded) {
+    spreaded = cv::Mat::zeros(quantized.rows, quantized.cols, CV_8UC1);
+    const int half = static_cast<int>(spreadSize) / 2;
+
+    // OR of quantized image shifted by each offset in neighbourhood, inner loop runs over continuous rows
+    for (int oy = -half; oy < static_cast<int>(spreadSize) - half; oy++) {
+        for (int ox = -half; ox < static_cast<int>(spreadSize) - half; ox++) {
+            const int x1 = std::max(0, -ox), x2 = std::min(quantized.cols, quantized.cols - ox);
+
+            for (int y = std::max(0, -oy); y < std::min(quantized.rows, quantized.rows - oy); y++) {
+                const uchar *pSrc = quantized.ptr<uchar>(y + oy) + ox;
+                uchar *pDst = spreaded.ptr<uchar>(y);
+
+                for (int x = x1; x < x2; x++) {
+                    pDst[x] |= pSrc[x];
+                }
+            }
+        }
+    }
+}
+
+void GradientResponse::linearize(const cv::Mat &response, int orientation, ResponseMaps &responseMaps) {
+    const int step = responseMaps.step;
+
+    // Each memory gathers pixels with the same offset within step x step cells
+    for (int oy = 0; oy < step; oy++) {
+        for (int ox = 0; ox < step; ox++) {
+            uchar *pMemory = responseMaps.memory(orientation, ox, oy);
+
+            for (int gy = 0; gy < responseMaps.rows; gy++) {
+                const uchar *pResponse = response.ptr<uchar>(gy * step + oy) + ox;
+                uchar *pDst = pMemory + gy * responseMaps.cols;
+
+                for (int gx = 0; gx < responseMaps.cols; gx++) {
+                    pDst[gx] = pResponse[gx * step];
+                }
+            }
+        }
+    }
+}
+
+void GradientResponse::computeResponseMaps(const cv::Mat &src, ResponseMaps &responseMaps) {
+    cv::Mat quantized, spreaded;
+    quantize(src, quantized);
+    spread(quantized, spreaded);
+
+    // Lookup tables of responses to lower and upper 4 bits of spread orientations
+    uchar luts[8][32];
+    for (int o = 0; o < ORIENTATIONS; o++) {
+        for (int v = 0; v < 16; v++) {
+            uchar lo = 0, hi = 0;
+            for (int b = 0; b < 4; b++) {
+                if (!(v & (1 << b))) continue;
+                const int dLo = std::min((o - b + 8) % 8, (b - o + 8) % 8);
+                const int dHi = std::min((o - b - 4 + 8) % 8, (b + 4 - o + 8) % 8);
+                lo = std::max<uchar>(lo, dLo == 0 ? MAX_RESPONSE : (dLo == 1 ? 1 : 0));
+                hi = std::max<uchar>(hi, dHi == 0 ? MAX_RESPONSE : (dHi == 1 ? 1 : 0));
+            }
+
+            luts[o][v] = lo;
+            luts[o][16 + v] = hi;
+        }
+    }
+
+    // Response of each orientation is max of both lookups, maps are linearized right after lookup
+    responseMaps.create(ORIENTATIONS, static_cast<int>(spreadSize), spreaded.cols, spreaded.rows);
+    cv::Mat response(spreaded.rows, spreaded.cols, CV_8UC1);
+    const int total = static_cast<int>(spreaded.total());
+    const uchar *pSpread = spreaded.ptr<uchar>();
+    uchar *pResponse = response.ptr<uchar>();
+    for (int o = 0; o < ORIENTATIONS; o++) {
+        int i = 0;
+
+#ifdef __SSSE3__
+        // 16 pixels per iteration, both lookups done by byte shuffle
+        const __m128i lutLo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(luts[o]));
+        const __m128i lutHi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(luts[o] + 16));
+        const __m128i lowMask = _mm_set1_epi8(0x0F);
+        for (; i + 16 <= total; i += 16) {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSpread + i));
+            const __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(s, lowMask));
+            const __m128i hi = _mm_shuffle_epi8(lutHi, _mm_and_si128(_mm_srli_epi16(s, 4), lowMask));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pResponse + i), _mm_max_epu8(lo, hi));
+        }
+#endif
+
+        for (; i < total; i++) {
+            pResponse[i] = std::max(luts[o][pSpread[i] & 15], luts[o][16 + (pSpread[i] >> 4)]);
+        }
+
+        linearize(response, o, responseMaps);
+    }
+}
+
+// Getters and setters
+bool GradientResponse::isEnabled() const {
+    return enabled;
+}
+
+float GradientResponse::getMinMagnitude() const {
+    return minMagnitude;
+}
+
+unsigned int GradientResponse::getSpreadSize() const {
+    return spreadSize;
+}
+
+void GradientResponse::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void GradientResponse::setMinMagnitude(float minMagnitude) {
+    assert(minMagnitude >= 0);
+    this->minMagnitude = minMagnitude;
+}
+
+void GradientResponse::setSpreadSize(unsigned int spreadSize) {
+    assert(spreadSize > 0);
+    this->spreadSize = spreadSize;
+}
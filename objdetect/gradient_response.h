@@ -0,0 +1,49 @@
+#ifndef VSB_SEMESTRAL_PROJECT_GRADIENT_RESPONSE_H
+#define VSB_SEMESTRAL_PROJECT_GRADIENT_RESPONSE_H
+
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "../core/response_maps.h"
+
+/**
+ * class GradientResponse
+ *
+ * Quantized gradient orientations as in LINE-MOD. Gradient orientations (modulo 180 deg) with magnitude
+ * above minMagnitude are quantized into 8 bins, each pixel is stored as byte with bit of its bin set.
+ * Orientations of scene are spread by OR over spreadSize x spreadSize neighbourhood and response map
+ * of each orientation is precomputed from the spread image (4 = same orientation in neighbourhood,
+ * 1 = neighbouring orientation, 0 otherwise), so similarity of template gradient at any location
+ * is a single byte lookup. Response maps are linearized with step = spreadSize (see ResponseMaps).
+ */
+class GradientResponse {
+private:
+    bool enabled;
+    float minMagnitude; // Min gradient magnitude of quantized pixels, images are in <0, 1> [0.1]
+    unsigned int spreadSize; // Size of neighbourhood orientations are spread in [4]
+
+    void spread(const cv::Mat &quantized, cv::Mat &spreaded);
+    void linearize(const cv::Mat &response, int orientation, ResponseMaps &responseMaps);
+public:
+    static const int ORIENTATIONS;
+    static const uchar MAX_RESPONSE;
+
+    // Constructors
+    GradientResponse(bool enabled = false, float minMagnitude = 0.1f, unsigned int spreadSize = 4)
+        : enabled(enabled), minMagnitude(minMagnitude), spreadSize(spreadSize) {}
+
+    // Methods
+    void quantize(const cv::Mat &src, cv::Mat &quantized); // src CV_32F, quantized CV_8U (bit of orientation bin, 0 = weak gradient)
+    void computeResponseMaps(const cv::Mat &src, ResponseMaps &responseMaps);
+
+    // Getters
+    bool isEnabled() const;
+    float getMinMagnitude() const;
+    unsigned int getSpreadSize() const;
+
+    // Setters
+    void setEnabled(bool enabled);
+    void setMinMagnitude(float minMagnitude);
+    void setSpreadSize(unsigned int spreadSize);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_GRADIENT_RESPONSE_H
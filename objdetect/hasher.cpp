@@ -4,22 +4,30 @@
 
 const int Hasher::IMG_16BIT_VALUE_MAX = 65535; // <0, 65535> => 65536 values
 const int Hasher::IMG_16BIT_VALUES_RANGE = (IMG_16BIT_VALUE_MAX * 2) + 1; // <-65535, 65535> => 131071 values + (one zero)
+const HashKey Hasher::INVALID_KEY = HashKey(-1, -1, -1, -1, -1);
+const size_t Hasher::MIN_TABLES_PER_INDEX = 20;
 
+template <typename T>
 cv::Vec3d Hasher::extractSurfaceNormal(const cv::Mat &src, const cv::Point c) {
     // Checks
     assert(!src.empty());
+    assert(src.elemSize() == sizeof(T));
 
-    float dzdx = (src.at<float>(c.y, c.x + 1) - src.at<float>(c.y, c.x - 1)) / 2.0f;
-    float dzdy = (src.at<float>(c.y + 1, c.x) - src.at<float>(c.y - 1, c.x)) / 2.0f;
+    float dzdx = (static_cast<float>(src.at<T>(c.y, c.x + 1)) - src.at<T>(c.y, c.x - 1)) / 2.0f;
+    float dzdy = (static_cast<float>(src.at<T>(c.y + 1, c.x)) - src.at<T>(c.y - 1, c.x)) / 2.0f;
     cv::Vec3f d(-dzdy, -dzdx, 1.0f);
 
     return cv::normalize(d);
 }
 
+template <typename T>
 cv::Vec2i Hasher::extractRelativeDepths(const cv::Mat &src, const cv::Point c, const cv::Point p1, const cv::Point p2) {
+    // Checks
+    assert(src.elemSize() == sizeof(T));
+
     return cv::Vec2i(
-        static_cast<int>(src.at<float>(p1) - src.at<float>(c)),
-        static_cast<int>(src.at<float>(p2) - src.at<float>(c))
+        static_cast<int>(static_cast<float>(src.at<T>(p1)) - src.at<T>(c)),
+        static_cast<int>(static_cast<float>(src.at<T>(p2)) - src.at<T>(c))
     );
 }
 
@@ -77,11 +85,149 @@ int Hasher::quantizeDepths(float depth) {
     return (int) histogramBinRanges.size() - 1;
 }
 
+int Hasher::quantizeSceneSurfaceNormal(const cv::Mat &sceneDepth, const cv::Mat &sceneNormals, cv::Mat &normalsCache, const cv::Point p) {
+    // Triplet points of overlapping windows hit the same scene pixels many times per frame,
+    // quantized normal is computed once per pixel and then only read from cache (-1 = not computed yet).
+    // Normals estimated for the whole frame are used if available, central differences otherwise
+    schar &cached = normalsCache.at<schar>(p);
+    if (cached < 0) {
+        cv::Vec3f normal = sceneNormals.empty() ? cv::Vec3f(extractSurfaceNormal<float>(sceneDepth, p)) : sceneNormals.at<cv::Vec3f>(p);
+        cached = static_cast<schar>(quantizeSurfaceNormals(normal));
+    }
+
+    return cached;
+}
+
+void Hasher::quantizeTemplateSurfaceNormals(const TemplateStore &store, const HashIndex &index, std::vector<schar> &normals) {
+    // Quantized normals at c, p1, p2 of each table, normals of template with handle h are stored
+    // from (h - firstHandle) * tables * 3, plane fit normals estimated after parsing are used if available
+    const int tables = static_cast<int>(index.hashTables.size());
+    const int count = static_cast<int>(index.templateCount());
+    normals.resize(static_cast<size_t>(count) * tables * 3);
+
+    #pragma omp parallel for
+    for (int i = 0; i < count; i++) {
+        const Template &t = store[index.firstHandle + i];
+        assert(!t.srcDepth.empty());
+
+        const cv::Mat &normalMap = t.srcNormals;
+        TripletCoords coordParams = Triplet::getCoordParams(t.srcDepth.cols, t.srcDepth.rows, referencePointsGrid);
+        schar *pNormals = normals.data() + static_cast<size_t>(i) * tables * 3;
+        for (int j = 0; j < tables; j++) {
+            Triplet triplet = index.hashTables[j].triplet;
+            const cv::Point points[3] = { triplet.getCenterCoords(coordParams), triplet.getP1Coords(coordParams), triplet.getP2Coords(coordParams) };
+
+            for (int k = 0; k < 3; k++) {
+                cv::Vec3f normal = normalMap.empty() ? cv::Vec3f(extractSurfaceNormal<ushort>(t.srcDepth, points[k])) : normalMap.at<cv::Vec3f>(points[k]);
+                pNormals[j * 3 + k] = static_cast<schar>(quantizeSurfaceNormals(normal));
+            }
+        }
+    }
+}
+
+template <int BINS>
+int Hasher::quantizeDepthsKernel(int depth, const cv::Range *ranges, int bins) {
+    // Same quantization as quantizeDepths, first matching bin is selected without branches,
+    // with BINS known at compile time the loop is fully unrolled
+    const int binCount = (BINS > 0) ? BINS : bins;
+    int bin = binCount - 1;
+
+    for (int i = binCount - 1; i >= 0; i--) {
+        bin = (ranges[i].start >= depth && depth < ranges[i].end) ? i : bin;
+    }
+
+    return bin;
+}
+
+template <int BINS, int TABLES>
+int Hasher::extractWindowKeysKernel(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals, cv::Mat &normalsCache,
+                                    const TripletLayout &layout, const std::vector<cv::Range> &ranges, const cv::Point tl,
+                                    std::vector<HashKey> &keys) {
+    // Checks
+    assert(TABLES == 0 || static_cast<int>(layout.size()) == TABLES);
+    assert(BINS == 0 || static_cast<int>(ranges.size()) == BINS);
+    assert(keys.size() == layout.size());
+
+    const int tableCount = (TABLES > 0) ? TABLES : static_cast<int>(layout.size());
+    const int bins = static_cast<int>(ranges.size());
+    const cv::Range *pRanges = ranges.data();
+    int relativeDepths1[(TABLES > 0) ? TABLES : 1], relativeDepths2[(TABLES > 0) ? TABLES : 1];
+    std::vector<int> dynamicDepths1, dynamicDepths2;
+    int *d1 = relativeDepths1, *d2 = relativeDepths2;
+
+    // Runtime number of tables needs heap buffers
+    if (TABLES == 0) {
+        dynamicDepths1.resize(tableCount);
+        dynamicDepths2.resize(tableCount);
+        d1 = dynamicDepths1.data();
+        d2 = dynamicDepths2.data();
+    }
+
+    // Relative depths of all tables, only loads at precomputed offsets from window origin
+    const float *origin = sceneDepth.ptr<float>(tl.y) + tl.x;
+    const int *cOffsets = layout.cOffsets.data(), *p1Offsets = layout.p1Offsets.data(), *p2Offsets = layout.p2Offsets.data();
+    for (int i = 0; i < tableCount; i++) {
+        d1[i] = static_cast<int>(origin[p1Offsets[i]] - origin[cOffsets[i]]);
+        d2[i] = static_cast<int>(origin[p2Offsets[i]] - origin[cOffsets[i]]);
+    }
+
+    // Generate hash keys, triplets with any point without valid depth are skipped
+    const uchar *validOrigin = sceneDepthValid.ptr<uchar>(tl.y) + tl.x;
+    int invalid = 0;
+    for (int i = 0; i < tableCount; i++) {
+        if (!(validOrigin[cOffsets[i]] & validOrigin[p1Offsets[i]] & validOrigin[p2Offsets[i]])) {
+            keys[i] = INVALID_KEY;
+            invalid++;
+            continue;
+        }
+
+        keys[i] = HashKey(
+            quantizeDepthsKernel<BINS>(d1[i], pRanges, bins),
+            quantizeDepthsKernel<BINS>(d2[i], pRanges, bins),
+            quantizeSceneSurfaceNormal(sceneDepth, sceneNormals, normalsCache, tl + layout.c[i]),
+            quantizeSceneSurfaceNormal(sceneDepth, sceneNormals, normalsCache, tl + layout.p1[i]),
+            quantizeSceneSurfaceNormal(sceneDepth, sceneNormals, normalsCache, tl + layout.p2[i])
+        );
+    }
+
+    return invalid;
+}
+
+int Hasher::extractWindowKeys(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals, cv::Mat &normalsCache,
+                              const TripletLayout &layout, const std::vector<cv::Range> &ranges, const cv::Point tl,
+                              std::vector<HashKey> &keys) {
+    const int tables = static_cast<int>(layout.size());
+    const int bins = static_cast<int>(ranges.size());
+
+    // Specialized kernels for common configurations, generic kernel otherwise
+    if (bins == 5 && tables == 100) {
+        return extractWindowKeysKernel<5, 100>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else if (bins == 5 && tables == 50) {
+        return extractWindowKeysKernel<5, 50>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else if (bins == 5 && tables == 200) {
+        return extractWindowKeysKernel<5, 200>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else if (bins == 5) {
+        return extractWindowKeysKernel<5, 0>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else if (bins == 4) {
+        return extractWindowKeysKernel<4, 0>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else if (bins == 6) {
+        return extractWindowKeysKernel<6, 0>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    } else {
+        return extractWindowKeysKernel<0, 0>(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, ranges, tl, keys);
+    }
+}
+
 void Hasher::generateTriplets(std::vector<HashTable> &hashTables) {
-    // Generate triplets
+    // Generate triplets in parallel, i-th triplet is drawn from i-th stream so result doesn't depend on threads
+    std::vector<RandomStream> streams;
+    for (int i = 0; i < hashTableCount; ++i) {
+        streams.push_back(RandomStream(seed, static_cast<uint64_t>(i)));
+        hashTables.push_back(HashTable(Triplet(), seed, static_cast<uint64_t>(i)));
+    }
+
+    #pragma omp parallel for
     for (int i = 0; i < hashTableCount; ++i) {
-        HashTable h(Triplet::createRandomTriplet(referencePointsGrid, maxTripletDistance));
-        hashTables.push_back(h);
+        hashTables[i].triplet = Triplet::createRandomTriplet(streams[i], referencePointsGrid, maxTripletDistance);
     }
 
     // TODO - joint entropy of 5k triplets, instead of 100 random triplets
@@ -96,7 +242,7 @@ void Hasher::generateTriplets(std::vector<HashTable> &hashTables) {
                 if (hashTables[i].triplet == hashTables[j].triplet) {
                     // Duplicate generate new triplet
                     duplicate = true;
-                    hashTables[j].triplet = Triplet::createRandomTriplet(referencePointsGrid);
+                    hashTables[j].triplet = Triplet::createRandomTriplet(streams[j], referencePointsGrid, maxTripletDistance);
                 }
             }
         }
@@ -146,7 +292,7 @@ void Hasher::calculateDepthHistogramRanges(unsigned long histogramSum, unsigned
     setHistogramBinRanges(ranges);
 }
 
-void Hasher::calculateDepthBinRanges(const std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables) {
+void Hasher::calculateDepthBinRanges(const TemplateStore &store) {
     // Histogram values <-65535, +65535> possible values
     unsigned long histogramValues[IMG_16BIT_VALUES_RANGE];
     unsigned long histogramSum = 0;
@@ -156,35 +302,34 @@ void Hasher::calculateDepthBinRanges(const std::vector<TemplateGroup> &groups, s
         histogramValues[i] = 0;
     }
 
-    // Calculate histogram values, using generated triplets and relative depths calculation
-    for (auto &hashTable : hashTables) {
-        for (auto &group : groups) {
-            for (auto &t : group.templates) {
-                // Checks
-                assert(!t.srcDepth.empty());
-
-                // Get triplet points
-                TripletCoords coordParams = Triplet::getCoordParams(t.srcDepth.cols, t.srcDepth.rows, referencePointsGrid);
-                cv::Point c = hashTable.triplet.getCenterCoords(coordParams);
-                cv::Point p1 = hashTable.triplet.getP1Coords(coordParams);
-                cv::Point p2 = hashTable.triplet.getP2Coords(coordParams);
-
-                // Check if we're not out of bounds
-                assert(c.x >= 0 && c.x < t.srcDepth.cols);
-                assert(c.y >= 0 && c.y < t.srcDepth.rows);
-                assert(p1.x >= 0 && p1.x < t.srcDepth.cols);
-                assert(p1.y >= 0 && p1.y < t.srcDepth.rows);
-                assert(p2.x >= 0 && p2.x < t.srcDepth.cols);
-                assert(p2.y >= 0 && p2.y < t.srcDepth.rows);
-
-                // Relative depths
-                cv::Vec2i relativeDepths = extractRelativeDepths(t.srcDepth, c, p1, p2);
-
-                // Add offset and count given values
-                histogramValues[relativeDepths[0] + IMG_16BIT_VALUE_MAX] += 1;
-                histogramValues[relativeDepths[1] + IMG_16BIT_VALUE_MAX] += 1;
-                histogramSum += 2; // Add 2 to sum of histogram values
-            }
+    // Calculate histogram values over all templates, using shared triplets and relative depths calculation
+    for (auto &hashTable : sharedTables) {
+        for (auto &&t : store.templates) {
+
+            // Checks
+            assert(!t.srcDepth.empty());
+
+            // Get triplet points
+            TripletCoords coordParams = Triplet::getCoordParams(t.srcDepth.cols, t.srcDepth.rows, referencePointsGrid);
+            cv::Point c = hashTable.triplet.getCenterCoords(coordParams);
+            cv::Point p1 = hashTable.triplet.getP1Coords(coordParams);
+            cv::Point p2 = hashTable.triplet.getP2Coords(coordParams);
+
+            // Check if we're not out of bounds
+            assert(c.x >= 0 && c.x < t.srcDepth.cols);
+            assert(c.y >= 0 && c.y < t.srcDepth.rows);
+            assert(p1.x >= 0 && p1.x < t.srcDepth.cols);
+            assert(p1.y >= 0 && p1.y < t.srcDepth.rows);
+            assert(p2.x >= 0 && p2.x < t.srcDepth.cols);
+            assert(p2.y >= 0 && p2.y < t.srcDepth.rows);
+
+            // Relative depths
+            cv::Vec2i relativeDepths = extractRelativeDepths<ushort>(t.srcDepth, c, p1, p2);
+
+            // Add offset and count given values
+            histogramValues[relativeDepths[0] + IMG_16BIT_VALUE_MAX] += 1;
+            histogramValues[relativeDepths[1] + IMG_16BIT_VALUE_MAX] += 1;
+            histogramSum += 2; // Add 2 to sum of histogram values
         }
     }
 
@@ -192,74 +337,103 @@ void Hasher::calculateDepthBinRanges(const std::vector<TemplateGroup> &groups, s
     calculateDepthHistogramRanges(histogramSum, histogramValues);
 }
 
-void Hasher::initialize(const std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables) {
+void Hasher::initialize(const TemplateStore &store) {
     // Checks
-    assert(groups.size() > 0);
+    assert(store.size() > 0);
     assert(hashTableCount > 0);
     assert(referencePointsGrid.width > 0);
     assert(referencePointsGrid.height > 0);
 
-    // Init hash tables
-    hashTables.reserve(hashTableCount);
-    generateTriplets(hashTables);
+    // Init shared triplets, layout is compiled again for new triplets
+    sharedTables.clear();
+    sharedTables.reserve(hashTableCount);
+    generateTriplets(sharedTables);
+    layout = TripletLayout();
 
     // Calculate ranges of depth bins for training
     std::cout << "  |_ Calculating depth bin ranges... ";
-    calculateDepthBinRanges(groups, hashTables);
+    calculateDepthBinRanges(store);
+}
+
+void Hasher::train(const TemplateStore &store, std::vector<HashIndex> &indices) {
+    // Checks
+    assert(!indices.empty());
+
+    // Shared triplets and depth bins of all indices
+    initialize(store);
+
+    // Table budget is split between indices, each index gets its slice of shared triplets (slices of
+    // different indices overlap only if there are more than hashTableCount / MIN_TABLES_PER_INDEX indices)
+    const size_t shared = sharedTables.size();
+    const size_t perIndex = (indices.size() == 1) ? shared : std::min(shared, std::max(shared / indices.size(), MIN_TABLES_PER_INDEX));
+    for (size_t k = 0; k < indices.size(); k++) {
+        HashIndex &index = indices[k];
+        assert(index.firstHandle < index.lastHandle && index.lastHandle <= store.size());
+
+        index.hashTables.clear();
+        index.tableIds.clear();
+        for (size_t j = 0; j < perIndex; j++) {
+            const size_t id = (k * perIndex + j) % shared;
+            index.tableIds.push_back(static_cast<uint>(id));
+            index.hashTables.push_back(HashTable(sharedTables[id].triplet, sharedTables[id].seed, sharedTables[id].stream));
+        }
+
+        trainIndex(store, index);
+    }
 }
 
-void Hasher::train(std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables) {
-    // Prepare hash tables and histogram bin ranges
-    initialize(groups, hashTables);
+void Hasher::trainIndex(const TemplateStore &store, HashIndex &index) {
+    std::vector<HashTable> &hashTables = index.hashTables;
+
+    // Quantized normals at triplet points, estimated same way as in the scene
+    std::vector<schar> normals;
+    quantizeTemplateSurfaceNormals(store, index, normals);
+    const size_t tables = hashTables.size();
 
     // Fill hash tables with templates and keys quantizied from measured values
-    for (auto &hashTable : hashTables) {
-        for (auto &group : groups) {
-            for (auto &t : group.templates) {
-                // Checks
-                assert(!t.srcDepth.empty());
-
-                // Get triplet points
-                TripletCoords coordParams = Triplet::getCoordParams(t.srcDepth.cols, t.srcDepth.rows, referencePointsGrid);
-                cv::Point c = hashTable.triplet.getCenterCoords(coordParams);
-                cv::Point p1 = hashTable.triplet.getP1Coords(coordParams);
-                cv::Point p2 = hashTable.triplet.getP2Coords(coordParams);
-
-                // Check if we're not out of bounds
-                assert(c.x >= 0 && c.x < t.srcDepth.cols);
-                assert(c.y >= 0 && c.y < t.srcDepth.rows);
-                assert(p1.x >= 0 && p1.x < t.srcDepth.cols);
-                assert(p1.y >= 0 && p1.y < t.srcDepth.rows);
-                assert(p2.x >= 0 && p2.x < t.srcDepth.cols);
-                assert(p2.y >= 0 && p2.y < t.srcDepth.rows);
-
-                // Relative depths
-                cv::Vec2i relativeDepths = extractRelativeDepths(t.srcDepth, c, p1, p2);
-
-                // Generate hash key
-                HashKey key(
-                    quantizeDepths(relativeDepths[0]),
-                    quantizeDepths(relativeDepths[1]),
-                    quantizeSurfaceNormals(extractSurfaceNormal(t.srcDepth, c)),
-                    quantizeSurfaceNormals(extractSurfaceNormal(t.srcDepth, p1)),
-                    quantizeSurfaceNormals(extractSurfaceNormal(t.srcDepth, p2))
-                );
-
-                // Check if key exists, if not initialize it
-                if (hashTable.templates.find(key) == hashTable.templates.end()) {
-                    std::vector<Template *> hashTemplates;
-                    hashTable.templates[key] = hashTemplates;
-                }
+    for (size_t i = 0; i < tables; i++) {
+        HashTable &hashTable = hashTables[i];
+        for (uint handle = index.firstHandle; handle < index.lastHandle; handle++) {
+            const Template &t = store[handle];
 
-                // Check for duplicates in hash table and push unique
-                auto found = std::find_if(hashTable.templates[key].begin(), hashTable.templates[key].end(), [&t](const Template* tt) { return t == *tt; });
-                if (found == hashTable.templates[key].end()) {
-                    hashTable.templates[key].push_back(&t);
-                }
+            // Checks
+            assert(!t.srcDepth.empty());
+
+            // Get triplet points
+            TripletCoords coordParams = Triplet::getCoordParams(t.srcDepth.cols, t.srcDepth.rows, referencePointsGrid);
+            cv::Point c = hashTable.triplet.getCenterCoords(coordParams);
+            cv::Point p1 = hashTable.triplet.getP1Coords(coordParams);
+            cv::Point p2 = hashTable.triplet.getP2Coords(coordParams);
+
+            // Check if we're not out of bounds
+            assert(c.x >= 0 && c.x < t.srcDepth.cols);
+            assert(c.y >= 0 && c.y < t.srcDepth.rows);
+            assert(p1.x >= 0 && p1.x < t.srcDepth.cols);
+            assert(p1.y >= 0 && p1.y < t.srcDepth.rows);
+            assert(p2.x >= 0 && p2.x < t.srcDepth.cols);
+            assert(p2.y >= 0 && p2.y < t.srcDepth.rows);
+
+            // Relative depths
+            cv::Vec2i relativeDepths = extractRelativeDepths<ushort>(t.srcDepth, c, p1, p2);
+
+            // Generate hash key
+            const schar *n = normals.data() + ((handle - index.firstHandle) * tables + i) * 3;
+            HashKey key(quantizeDepths(relativeDepths[0]), quantizeDepths(relativeDepths[1]), n[0], n[1], n[2]);
+
+            // Check for duplicates in hash table and push unique (key is initialized if it doesn't exist)
+            std::vector<uint> &hashTemplates = hashTable.templates[key];
+            if (std::find(hashTemplates.begin(), hashTemplates.end(), handle) == hashTemplates.end()) {
+                hashTemplates.push_back(handle);
             }
         }
+
+        // Bins as template bitsets for bitset voting
+        hashTable.buildBitsets(index.firstHandle, index.lastHandle);
     }
 
+    // Signature used to route windows to this index
+    index.computeSignature(store);
+
 #ifndef NDEBUG
     // Visualize triplets
     cv::Mat triplet = cv::Mat::zeros(400, 400, CV_32FC3), triplets = cv::Mat::zeros(400, 400, CV_32FC3);
@@ -281,62 +455,216 @@ void Hasher::train(std::vector<TemplateGroup> &groups, std::vector<HashTable> &h
 #endif
 }
 
-void Hasher::verifyTemplateCandidates(const cv::Mat &sceneDepth, std::vector<HashTable> &hashTables, std::vector<Window> &windows) {
+void Hasher::extractWindowDepths(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, std::vector<Window> &windows) {
+    // Integral images of depth values and of valid depth pixels (invalid pixels have zero depth)
+    cv::Mat depthSum, validSum;
+    cv::integral(sceneDepth, depthSum, CV_64F);
+    cv::integral(sceneDepthValid, validSum, CV_32S);
+
+    for (auto &&window : windows) {
+        // Object lies in the middle of window, depth is taken from central half of the window to skip
+        // background around it, whole window is used only if the centre has no valid depth
+        const cv::Rect centre(window.x + window.width / 4, window.y + window.height / 4, std::max(1, window.width / 2),
+                              std::max(1, window.height / 2));
+        const cv::Rect rects[] = {centre, cv::Rect(window.tl(), window.br())};
+
+        window.depth = 0;
+        for (auto &&rect : rects) {
+            cv::Point tl = rect.tl(), br = rect.br();
+            int count = validSum.at<int>(br.y, br.x) - validSum.at<int>(tl.y, br.x)
+                        - validSum.at<int>(br.y, tl.x) + validSum.at<int>(tl.y, tl.x);
+            double sum = depthSum.at<double>(br.y, br.x) - depthSum.at<double>(tl.y, br.x)
+                         - depthSum.at<double>(br.y, tl.x) + depthSum.at<double>(tl.y, tl.x);
+
+            if (count > 0) {
+                window.depth = static_cast<float>(sum / count) * depthScale;
+                break;
+            }
+        }
+    }
+}
+
+void Hasher::votePostings(TemplateStore &store, const HashIndex &index, const std::vector<HashKey> &keys,
+                          const std::vector<uchar> &mask, std::vector<std::pair<int, uint>> &voted) {
+    std::vector<int> &votes = store.metadata.votes;
+    const std::vector<HashTable> &hashTables = index.hashTables;
+    std::vector<uint> usedTemplates;
+
+    for (size_t i = 0; i < hashTables.size(); i++) {
+        const HashKey &key = keys[index.tableIds[i]];
+        if (key.d1 < 0) continue;
+        auto bin = hashTables[i].templates.find(key);
+        if (bin == hashTables[i].templates.end()) continue;
+
+        // Vote for each template in hash table at specific key
+        for (auto &entry : bin->second) {
+            if (!mask[entry]) continue;
+            if (votes[entry]++ == 0) usedTemplates.push_back(entry);
+        }
+    }
+
+    // Collect templates with enough votes and reset votes of all used templates
+    for (auto &&handle : usedTemplates) {
+        if (votes[handle] >= minVotesPerTemplate) {
+            voted.push_back(std::make_pair(votes[handle], handle));
+        }
+        votes[handle] = 0;
+    }
+}
+
+void Hasher::voteBitsets(const HashIndex &index, const std::vector<HashKey> &keys, const std::vector<uchar> &mask,
+                         std::vector<std::vector<uint64_t>> &planes, std::vector<std::pair<int, uint>> &voted) {
+    // Checks
+    assert(!planes.empty());
+    assert(planes[0].size() >= index.wordCount());
+
+    const std::vector<HashTable> &hashTables = index.hashTables;
+    const size_t words = index.wordCount(), firstWord = index.firstWord();
+    const size_t planeCount = planes.size();
+    for (auto &&plane : planes) {
+        std::fill(plane.begin(), plane.begin() + words, 0);
+    }
+
+    // Bit-sliced counters, bit i of plane k is k-th bit of vote count of template i. Bitset of each
+    // table is added by ripple carry over planes, whole 64 templates are counted per word operation
+    std::vector<uint64_t> carry(words);
+    for (size_t i = 0; i < hashTables.size(); i++) {
+        const HashKey &key = keys[index.tableIds[i]];
+        if (key.d1 < 0) continue;
+        auto bin = hashTables[i].bitsets.find(key);
+        if (bin == hashTables[i].bitsets.end()) continue;
+
+        const uint64_t *bitset = bin->second.data();
+        uint64_t *pCarry = carry.data();
+        std::copy(bitset, bitset + words, pCarry);
+
+        for (size_t k = 0; k < planeCount; k++) {
+            uint64_t *plane = planes[k].data();
+            for (size_t w = 0; w < words; w++) {
+                const uint64_t sum = plane[w] ^ pCarry[w];
+                pCarry[w] = plane[w] & pCarry[w];
+                plane[w] = sum;
+            }
+        }
+    }
+
+    // Read counts of templates with any vote which passed prefilters
+    for (size_t w = 0; w < words; w++) {
+        uint64_t any = 0;
+        for (size_t k = 0; k < planeCount; k++) {
+            any |= planes[k][w];
+        }
+
+        while (any) {
+            const int bit = __builtin_ctzll(any);
+            any &= any - 1;
+
+            const uint handle = static_cast<uint>((firstWord + w) * 64 + bit);
+            if (!mask[handle]) continue;
+
+            int count = 0;
+            for (size_t k = 0; k < planeCount; k++) {
+                count |= static_cast<int>((planes[k][w] >> bit) & 1ULL) << k;
+            }
+
+            if (count >= minVotesPerTemplate) {
+                voted.push_back(std::make_pair(count, handle));
+            }
+        }
+    }
+}
+
+void Hasher::verifyTemplateCandidates(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals,
+                                      TemplateStore &store, std::vector<HashIndex> &indices, std::vector<Window> &windows,
+                                      float edgelsFactor) {
     // Checks
     assert(!sceneDepth.empty());
+    assert(sceneDepthValid.size() == sceneDepth.size());
+    assert(sceneDepthValid.step1() == sceneDepth.step1()); // Triplet offsets are shared by both images
+    assert(sceneNormals.empty() || sceneNormals.size() == sceneDepth.size());
     assert(windows.size() > 0);
-    assert(hashTables.size() > 0);
+    assert(indices.size() > 0);
 
     int notEmptyWindows = 0;
     unsigned long reduced = 0;
-    std::vector<Template *> usedTemplates;
+    std::vector<uchar> mask(store.size());
+    cv::Mat normalsCache(sceneDepth.size(), CV_8SC1, cv::Scalar(-1));
+
+    // Keys of all shared tables are computed at once per window, indices only look them up
+    const size_t rowStride = sceneDepth.step1();
+    std::vector<HashKey> keys;
+    std::vector<std::pair<int, uint>> voted;
+
+    // Bit planes of bit-sliced vote counters, enough to count votes from all tables of the largest index
+    size_t maxTables = 0, maxWords = 0, planeCount = 1;
+    for (auto &&index : indices) {
+        maxTables = std::max(maxTables, index.hashTables.size());
+        maxWords = std::max(maxWords, index.wordCount());
+    }
+    while ((1UL << planeCount) <= maxTables) planeCount++;
+    std::vector<std::vector<uint64_t>> planes(planeCount, std::vector<uint64_t>(maxWords));
+    unsigned long routed = 0, invalidTriplets = 0;
+
+    // Mean depth of each window, used to pick templates rendered at similar distance (and by matcher to scale them)
+    extractWindowDepths(sceneDepth, sceneDepthValid, windows);
 
     for (auto &&window : windows) {
-        for (auto &&table : hashTables) {
-            // Get triplet points
-            TripletCoords coordParams = Triplet::getCoordParams(window.width, window.height, referencePointsGrid, window.tl().x, window.tl().y);
-            cv::Point c = table.triplet.getCenterCoords(coordParams);
-            cv::Point p1 = table.triplet.getP1Coords(coordParams);
-            cv::Point p2 = table.triplet.getP2Coords(coordParams);
+        // Prefilter templates rendered in depth band around window depth (all if depth is unknown)
+        const float z = window.depth;
+        if (depthBand > 0 && z > 0) {
+            std::fill(mask.begin(), mask.end(), 0);
+            store.metadata.selectDepth(z * (1 - depthBand), z * (1 + depthBand), mask);
+        } else {
+            std::fill(mask.begin(), mask.end(), 1);
+        }
 
-            // Check if we're not out of bounds
-            assert(c.x >= 0 && c.x < sceneDepth.cols);
-            assert(c.y >= 0 && c.y < sceneDepth.rows);
-            assert(p1.x >= 0 && p1.x < sceneDepth.cols);
-            assert(p1.y >= 0 && p1.y < sceneDepth.rows);
-            assert(p2.x >= 0 && p2.x < sceneDepth.cols);
-            assert(p2.y >= 0 && p2.y < sceneDepth.rows);
+        // Prefilter templates which don't fit into the scene at window location
+        store.metadata.filterSize(sceneDepth.cols - window.x, sceneDepth.rows - window.y, mask);
 
-            // Relative depths
-            cv::Vec2i relativeDepths = extractRelativeDepths(sceneDepth, c, p1, p2);
+        // Check if we're not out of bounds (all triplet points lie inside of window)
+        assert(window.x >= 0 && window.x + window.width < sceneDepth.cols);
+        assert(window.y >= 0 && window.y + window.height < sceneDepth.rows);
 
-            // Generate hash key
-            HashKey key(
-                quantizeDepths(relativeDepths[0]),
-                quantizeDepths(relativeDepths[1]),
-                quantizeSurfaceNormals(extractSurfaceNormal(sceneDepth, c)),
-                quantizeSurfaceNormals(extractSurfaceNormal(sceneDepth, p1)),
-                quantizeSurfaceNormals(extractSurfaceNormal(sceneDepth, p2))
-            );
-
-            // Vote for each template in hash table at specific key and push unique to window candidates
-            for (auto &entry : table.templates[key]) {
-                entry->voteUp();
-
-                // automatically pushes only unique templates with minimum of v minVotesPerTemplate and up to N of templates
-                window.pushUnique(entry, hashTableCount, minVotesPerTemplate);
-                usedTemplates.push_back(entry);
+        voted.clear();
+        bool keysExtracted = false;
+        for (auto &&index : indices) {
+            // Route window only to indices which can contain matching templates
+            if (!index.accepts(window, depthBand, edgelsFactor, sceneDepth.cols - window.x, sceneDepth.rows - window.y)) {
+                continue;
+            }
+            routed++;
+
+            // Hash keys of all shared tables, extracted once per window for the first routed index
+            if (!keysExtracted) {
+                const cv::Size windowSize(window.width, window.height);
+                if (!layout.isCompiledFor(windowSize, rowStride)) {
+                    layout = TripletLayout(windowSize, rowStride, sharedTables, referencePointsGrid);
+                }
+
+                keys.assign(sharedTables.size(), HashKey(0, 0, 0, 0, 0));
+                invalidTriplets += extractWindowKeys(sceneDepth, sceneDepthValid, sceneNormals, normalsCache, layout, histogramBinRanges,
+                                                     cv::Point(window.x, window.y), keys);
+                keysExtracted = true;
             }
-            reduced += window.candidatesSize();
-        }
 
-        // Reset minVotesPerTemplate for all used templates
-        for (auto &&t : usedTemplates) {
-            t->resetVotes();
+            // Vote for templates in bins of index tables
+            if (bitsetVoting) {
+                voteBitsets(index, keys, mask, planes, voted);
+            } else {
+                votePostings(store, index, keys, mask, voted);
+            }
         }
 
-        // Clear used templates vector
-        usedTemplates.clear();
+        // Both engines keep up to hashTableCount templates with most votes over all routed indices
+        const size_t n = std::min<size_t>(hashTableCount, voted.size());
+        std::partial_sort(voted.begin(), voted.begin() + n, voted.end(), [](const std::pair<int, uint> &a, const std::pair<int, uint> &b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+
+        for (size_t i = 0; i < n; i++) {
+            window.candidates.push_back(voted[i].second);
+        }
+        reduced += window.candidatesSize();
 
         // TODO pass only windows with candidates
         if (window.hasCandidates()) {
@@ -344,6 +672,8 @@ void Hasher::verifyTemplateCandidates(const cv::Mat &sceneDepth, std::vector<Has
         }
     }
 
+    std::cout << "  |_ Triplets skipped on invalid depth: " << invalidTriplets << std::endl;
+    std::cout << "  |_ Average number of hash indices per window: " << routed / static_cast<float>(windows.size()) << std::endl;
     std::cout << "  |_ Number of windows pass to next stage: " << notEmptyWindows << std::endl;
     std::cout << "  |_ Total number of templates in windows reduced to approx: " << reduced / windows.size() << std::endl;
 }
@@ -387,7 +717,7 @@ void Hasher::setHashTableCount(unsigned int hashTableCount) {
 }
 
 void Hasher::setHistogramBinRanges(const std::vector<cv::Range> &histogramBinRanges) {
-    assert(histogramBinRanges.size() == 5);
+    assert(histogramBinRanges.size() == histogramBinCount);
     this->histogramBinRanges = histogramBinRanges;
 }
 
@@ -400,3 +730,45 @@ void Hasher::setMaxTripletDistance(unsigned int maxTripletDistance) {
     assert(maxTripletDistance > 1);
     this->maxTripletDistance = maxTripletDistance;
 }
+
+float Hasher::getDepthScale() const {
+    return depthScale;
+}
+
+float Hasher::getDepthBand() const {
+    return depthBand;
+}
+
+void Hasher::setDepthScale(float depthScale) {
+    assert(depthScale > 0);
+    this->depthScale = depthScale;
+}
+
+void Hasher::setDepthBand(float depthBand) {
+    assert(depthBand >= 0 && depthBand < 1);
+    this->depthBand = depthBand;
+}
+
+uint64_t Hasher::getSeed() const {
+    return seed;
+}
+
+void Hasher::setSeed(uint64_t seed) {
+    this->seed = seed;
+}
+
+bool Hasher::isBitsetVoting() const {
+    return bitsetVoting;
+}
+
+void Hasher::setBitsetVoting(bool bitsetVoting) {
+    this->bitsetVoting = bitsetVoting;
+}
+
+bool Hasher::isPerObjectIndices() const {
+    return perObjectIndices;
+}
+
+void Hasher::setPerObjectIndices(bool perObjectIndices) {
+    this->perObjectIndices = perObjectIndices;
+}
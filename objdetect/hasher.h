@@ -3,7 +3,9 @@
 
 #include <opencv2/opencv.hpp>
 #include "../core/hash_table.h"
-#include "../core/template_group.h"
+#include "../core/triplet_layout.h"
+#include "../core/hash_index.h"
+#include "../core/template_store.h"
 #include "../core/window.h"
 
 /**
@@ -11,7 +13,8 @@
  *
  * Class used to train templates and sliding windows, to prefilter
  * number of templates needed to be template matched in other stages of
- * template matching.
+ * template matching. Triplets and depth bins are trained once and shared by all hash indices,
+ * so hash keys are extracted once per window, per-object indices split the table budget between them.
  */
 class Hasher {
 private:
@@ -21,32 +24,69 @@ private:
     unsigned int hashTableCount;
     unsigned int histogramBinCount;
     std::vector<cv::Range> histogramBinRanges;
+    std::vector<HashTable> sharedTables; // Triplets shared by all indices (without templates)
+    TripletLayout layout; // Shared triplets compiled for last window size
+    float depthScale; // Scene depth units to mm (templates are indexed by camTm2c in mm)
+    float depthBand; // Relative depth band around window depth, 0 disables depth prefilter
+    uint64_t seed; // Seed of random streams triplets are generated from (recorded in each hash table)
+    bool bitsetVoting; // Count votes by bit-sliced addition of template bitsets instead of per posting counters
+    bool perObjectIndices; // Train separate hash index for each object (template group) instead of one for whole catalog
 
-    // Methods
+    // Methods, T is depth type (ushort for templates, float for scene)
+    template <typename T>
     cv::Vec3d extractSurfaceNormal(const cv::Mat &src, const cv::Point c);
+    template <typename T>
     cv::Vec2i extractRelativeDepths(const cv::Mat &src, const cv::Point c, const cv::Point p1, const cv::Point p2);
 
     int quantizeSurfaceNormals(cv::Vec3f normal);
     int quantizeDepths(float depth);
+    int quantizeSceneSurfaceNormal(const cv::Mat &sceneDepth, const cv::Mat &sceneNormals, cv::Mat &normalsCache, const cv::Point p);
+    void quantizeTemplateSurfaceNormals(const TemplateStore &store, const HashIndex &index, std::vector<schar> &normals);
+
+    // Hashing kernel computing keys of all tables in one window, BINS and TABLES are compile-time
+    // histogramBinCount and hashTableCount (0 = runtime value), dispatched by extractWindowKeys.
+    // Tables with triplet point without valid depth get INVALID_KEY, returns number of such tables
+    template <int BINS>
+    inline int quantizeDepthsKernel(int depth, const cv::Range *ranges, int bins);
+    template <int BINS, int TABLES>
+    int extractWindowKeysKernel(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals, cv::Mat &normalsCache,
+                                const TripletLayout &layout, const std::vector<cv::Range> &ranges, const cv::Point tl, std::vector<HashKey> &keys);
+    int extractWindowKeys(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals, cv::Mat &normalsCache,
+                          const TripletLayout &layout, const std::vector<cv::Range> &ranges, const cv::Point tl, std::vector<HashKey> &keys);
+
+    // Voting engines, append templates with at least minVotesPerTemplate votes (count, handle) from hash keys
+    // of index tables, window candidates are picked from votes of all routed indices
+    void votePostings(TemplateStore &store, const HashIndex &index, const std::vector<HashKey> &keys,
+                      const std::vector<uchar> &mask, std::vector<std::pair<int, uint>> &voted);
+    void voteBitsets(const HashIndex &index, const std::vector<HashKey> &keys, const std::vector<uchar> &mask,
+                     std::vector<std::vector<uint64_t>> &planes, std::vector<std::pair<int, uint>> &voted);
 
     void generateTriplets(std::vector<HashTable> &hashTables);
     void calculateDepthHistogramRanges(unsigned long histogramSum, unsigned long histogramValues[]);
-    void calculateDepthBinRanges(const std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables);
+    void calculateDepthBinRanges(const TemplateStore &store);
+    void trainIndex(const TemplateStore &store, HashIndex &index);
+    void extractWindowDepths(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, std::vector<Window> &windows);
 public:
     // Statics
     static const int IMG_16BIT_VALUE_MAX;
     static const int IMG_16BIT_VALUES_RANGE;
+    static const HashKey INVALID_KEY; // Key of triplet with point without valid depth, not voted for
+    static const size_t MIN_TABLES_PER_INDEX; // Per-object indices get at least this many of shared tables
 
     // Constructors
     Hasher(int minVotesPerTemplate = 3, cv::Size referencePointsGrid = cv::Size(12, 12),
-           unsigned int hashTableCount = 100, unsigned int histogramBinCount = 5, unsigned int maxTripletDistance = 3)
+           unsigned int hashTableCount = 100, unsigned int histogramBinCount = 5, unsigned int maxTripletDistance = 3,
+           float depthScale = 0.1f, float depthBand = 0, uint64_t seed = 1, bool bitsetVoting = false, bool perObjectIndices = false)
         : minVotesPerTemplate(minVotesPerTemplate), referencePointsGrid(referencePointsGrid),
-          hashTableCount(hashTableCount), histogramBinCount(histogramBinCount), maxTripletDistance(maxTripletDistance) {}
+          hashTableCount(hashTableCount), histogramBinCount(histogramBinCount), maxTripletDistance(maxTripletDistance),
+          depthScale(depthScale), depthBand(depthBand), seed(seed), bitsetVoting(bitsetVoting), perObjectIndices(perObjectIndices) {}
 
     // Methods
-    void initialize(const std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables);
-    void train(std::vector<TemplateGroup> &groups, std::vector<HashTable> &hashTables);
-    void verifyTemplateCandidates(const cv::Mat &sceneDepth, std::vector<HashTable> &hashTables, std::vector<Window> &windows);
+    void initialize(const TemplateStore &store);
+    void train(const TemplateStore &store, std::vector<HashIndex> &indices);
+    void verifyTemplateCandidates(const cv::Mat &sceneDepth, const cv::Mat &sceneDepthValid, const cv::Mat &sceneNormals,
+                                  TemplateStore &store, std::vector<HashIndex> &indices, std::vector<Window> &windows,
+                                  float edgelsFactor);
 
     // Getters
     const cv::Size getReferencePointsGrid();
@@ -55,6 +95,11 @@ public:
     unsigned int getHistogramBinCount() const;
     int getMinVotesPerTemplate() const;
     unsigned int getMaxTripletDistance() const;
+    float getDepthScale() const;
+    float getDepthBand() const;
+    uint64_t getSeed() const;
+    bool isBitsetVoting() const;
+    bool isPerObjectIndices() const;
 
     // Setters
     void setReferencePointsGrid(cv::Size referencePointsGrid);
@@ -63,6 +108,11 @@ public:
     void setHistogramBinCount(unsigned int histogramBinCount);
     void setMinVotesPerTemplate(int minVotesPerTemplate);
     void setMaxTripletDistance(unsigned int maxTripletDistance);
+    void setDepthScale(float depthScale);
+    void setDepthBand(float depthBand);
+    void setSeed(uint64_t seed);
+    void setBitsetVoting(bool bitsetVoting);
+    void setPerObjectIndices(bool perObjectIndices);
 };
 
 #endif //VSB_SEMESTRAL_PROJECT_HASHING_H
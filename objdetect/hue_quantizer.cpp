@@ -0,0 +1,82 @@
+#include "hue_quantizer.h"
+#include <cassert>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+
+// 8-bit OpenCV hue is in <0, 180)
+const uchar HueQuantizer::BLUE_HUE = 120;
+const uchar HueQuantizer::YELLOW_HUE = 30;
+
+void HueQuantizer::quantize(const cv::Mat &srcColor, cv::Mat &quantized) const {
+    // Checks
+    assert(!srcColor.empty());
+    assert(srcColor.type() == 16); // CV_8UC3
+
+    cv::Mat hsv;
+    cv::cvtColor(srcColor, hsv, CV_BGR2HSV);
+    quantized.create(srcColor.rows, srcColor.cols, CV_8UC1);
+
+    // Lookup table of hue bins, achromatic pixels are remapped before lookup
+    uchar lut[180];
+    for (int h = 0; h < 180; h++) {
+        lut[h] = static_cast<uchar>(h * hueBins / 180);
+    }
+
+    #pragma omp parallel for
+    for (int y = 0; y < hsv.rows; y++) {
+        const uchar *pHsv = hsv.ptr<uchar>(y);
+        uchar *pQuantized = quantized.ptr<uchar>(y);
+
+        for (int x = 0; x < hsv.cols; x++) {
+            uchar h = pHsv[3 * x], s = pHsv[3 * x + 1], v = pHsv[3 * x + 2];
+            if (v < minValue) {
+                h = BLUE_HUE;
+            } else if (s < minSaturation) {
+                h = YELLOW_HUE;
+            }
+
+            pQuantized[x] = lut[h];
+        }
+    }
+}
+
+int HueQuantizer::distance(uchar bin1, uchar bin2) const {
+    const int d = std::abs(bin1 - bin2);
+    return std::min(d, hueBins - d);
+}
+
+// Getters and setters
+bool HueQuantizer::isEnabled() const {
+    return enabled;
+}
+
+int HueQuantizer::getHueBins() const {
+    return hueBins;
+}
+
+int HueQuantizer::getMinSaturation() const {
+    return minSaturation;
+}
+
+int HueQuantizer::getMinValue() const {
+    return minValue;
+}
+
+void HueQuantizer::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void HueQuantizer::setHueBins(int hueBins) {
+    assert(hueBins > 0 && hueBins <= 180);
+    this->hueBins = hueBins;
+}
+
+void HueQuantizer::setMinSaturation(int minSaturation) {
+    assert(minSaturation >= 0 && minSaturation <= 255);
+    this->minSaturation = minSaturation;
+}
+
+void HueQuantizer::setMinValue(int minValue) {
+    assert(minValue >= 0 && minValue <= 255);
+    this->minValue = minValue;
+}
@@ -0,0 +1,45 @@
+#ifndef VSB_SEMESTRAL_PROJECT_HUE_QUANTIZER_H
+#define VSB_SEMESTRAL_PROJECT_HUE_QUANTIZER_H
+
+#include <opencv2/core/mat.hpp>
+
+/**
+ * class HueQuantizer
+ *
+ * Quantizes colors of BGR images into hueBins bins of HSV hue, so color of template feature point
+ * and scene pixel is compared as single byte. Hue of achromatic colors is undefined, so dark pixels
+ * (value < minValue) are assigned hue of blue and pixels with low saturation (saturation < minSaturation)
+ * hue of yellow. Templates quantized at load time and scene quantized once per frame use the same params.
+ */
+class HueQuantizer {
+private:
+    bool enabled;
+    int hueBins; // Number of hue bins [12]
+    int minSaturation; // Min saturation of chromatic pixels in <0, 255> [40]
+    int minValue; // Min value of chromatic pixels in <0, 255> [40]
+public:
+    static const uchar BLUE_HUE;
+    static const uchar YELLOW_HUE;
+
+    // Constructors
+    HueQuantizer(bool enabled = false, int hueBins = 12, int minSaturation = 40, int minValue = 40)
+        : enabled(enabled), hueBins(hueBins), minSaturation(minSaturation), minValue(minValue) {}
+
+    // Methods
+    void quantize(const cv::Mat &srcColor, cv::Mat &quantized) const; // srcColor CV_8UC3 (BGR), quantized CV_8UC1 (hue bin)
+    int distance(uchar bin1, uchar bin2) const; // Circular distance of hue bins
+
+    // Getters
+    bool isEnabled() const;
+    int getHueBins() const;
+    int getMinSaturation() const;
+    int getMinValue() const;
+
+    // Setters
+    void setEnabled(bool enabled);
+    void setHueBins(int hueBins);
+    void setMinSaturation(int minSaturation);
+    void setMinValue(int minValue);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_HUE_QUANTIZER_H
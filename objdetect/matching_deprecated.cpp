@@ -100,7 +100,7 @@ cv::Scalar matcher_deprecated::matRoiMean(cv::Size maskSize, cv::Rect roi) {
     return cv::mean(maskRoi);
 }
 
-std::vector<cv::Rect> matcher_deprecated::matchTemplate(const cv::Mat &input, std::vector<Window> &windows) {
+std::vector<cv::Rect> matcher_deprecated::matchTemplate(const cv::Mat &input, const TemplateStore &store, std::vector<Window> &windows) {
     // Checks
     assert(!input.empty());
 
@@ -119,7 +119,12 @@ std::vector<cv::Rect> matcher_deprecated::matchTemplate(const cv::Mat &input, st
         // Go through all candidates and take one with biggest score ?
         for (int i = 0; i < window.candidatesSize(); i++) {
             // TODO - Asserts
-            Template *t = window.candidates[i];
+            const Template *t = &store[window.candidates[i]];
+
+            // Skip templates whose foreground doesn't fit into the scene at window location
+            if (t->innerBB.area() == 0 || window.x + t->innerBB.br().x > input.cols || window.y + t->innerBB.br().y > input.rows) {
+                continue;
+            }
 
             // Set default helper variables for matching
             bool matchFound = false;
@@ -128,16 +133,15 @@ std::vector<cv::Rect> matcher_deprecated::matchTemplate(const cv::Mat &input, st
 
             float sum = 0, sumNormT = 0, sumNormI = 0;
 
-            // Loop through template
-            for (int ty = 0; ty < t->src.rows; ty++) {
-                for (int tx = 0; tx < t->src.cols; tx++) {
-                    float Ti = t->src.at<float>(ty, tx);
+            // Loop through foreground spans of template (black pixels are not part of them), raw 8-bit
+            // intensities are used since normalized cross correlation is invariant to scaling of template values
+            for (auto &&span : t->foregroundSpans) {
+                const uchar *pT = t->src.ptr<uchar>(span.y) + span.x;
+                const float *pI = input.ptr<float>(window.y + span.y) + window.x + span.x;
 
-                    // Ignore black pixels
-                    if (Ti == 0) continue;
-
-                    // Get input image value
-                    float Ii = input.at<float>(window.y + ty, window.x + tx);
+                for (int j = 0; j < span.length; j++) {
+                    float Ti = pT[j];
+                    float Ii = pI[j];
 
                     // Calculate sums for normalized cross correlation method
                     sum += ((Ii) * (Ti));
@@ -166,7 +170,10 @@ std::vector<cv::Rect> matcher_deprecated::matchTemplate(const cv::Mat &input, st
         }
     }
 
-
+    // Nothing to suppress if no window matched
+    if (matchBB.empty()) {
+        return matchBB;
+    }
 
     return nonMaximaSuppression(matchBB, scoreBB);
 
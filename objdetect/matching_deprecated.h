@@ -3,7 +3,7 @@
 
 #include <opencv2/opencv.hpp>
 #include "../core/template.h"
-#include "../core/template_group.h"
+#include "../core/template_store.h"
 #include "../core/hash_table.h"
 #include "../core/window.h"
 
@@ -19,7 +19,7 @@ namespace matcher_deprecated {
     cv::Scalar matRoiMean(cv::Size maskSize, cv::Rect roi);
 
     // Concludes template matching using CROSS CORRELATION function on given template groups and input image
-    std::vector<cv::Rect> matchTemplate(const cv::Mat &input, std::vector<Window> &windows);
+    std::vector<cv::Rect> matchTemplate(const cv::Mat &input, const TemplateStore &store, std::vector<Window> &windows);
 }
 
 #endif //VSB_SEMESTRAL_PROJECT_MATCHING_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "normal_estimator.h"
+#include <cassert>
+#include <opencv2/opencv.hpp>
+
+const int NormalEstimator::TERMS = 9;
+
+void NormalEstimator::estimate(const cv::Mat &depth, const cv::Mat &valid, cv::Mat &normals) const {
+    // Checks
+    assert(!depth.empty());
+    assert(depth.type() == 5); // CV_32FC1
+    assert(valid.type() == 0); // CV_8UC1
+    assert(depth.size() == valid.size());
+
+    // Integral image of all terms of the fit (w, x, y, xx, yy, xy, z, xz, yz) interleaved per pixel, built directly
+    // from row sums. Single terms fit float precision, only sums are accumulated in double, invalid pixels
+    // don't contribute to any sum
+    const int rows = depth.rows, cols = depth.cols;
+    cv::Mat sums = cv::Mat::zeros(rows + 1, cols + 1, CV_64FC(TERMS));
+
+    for (int r = 0; r < rows; r++) {
+        const float *pDepth = depth.ptr<float>(r);
+        const uchar *pValid = valid.ptr<uchar>(r);
+        const double *pAbove = sums.ptr<double>(r) + TERMS;
+        double *pSums = sums.ptr<double>(r + 1) + TERMS;
+        double rowSums[TERMS] = {0};
+
+        for (int c = 0; c < cols; c++) {
+            if (pValid[c]) {
+                const float x = static_cast<float>(c), y = static_cast<float>(r), d = pDepth[c];
+                const float terms[TERMS] = {1, x, y, x * x, y * y, x * y, d, d * x, d * y};
+                for (int k = 0; k < TERMS; k++) rowSums[k] += terms[k];
+            }
+
+            for (int k = 0; k < TERMS; k++) pSums[c * TERMS + k] = pAbove[c * TERMS + k] + rowSums[k];
+        }
+    }
+
+    // Plane z = a * x + b * y + c fitted over neighbourhood, solved from covariances of centred sums
+    normals.create(rows, cols, CV_32FC3);
+    const int rad = static_cast<int>(radius);
+
+    #pragma omp parallel for
+    for (int r = 0; r < rows; r++) {
+        const int y1 = std::max(0, r - rad), y2 = std::min(rows, r + rad + 1);
+        cv::Vec3f *pNormals = normals.ptr<cv::Vec3f>(r);
+
+        for (int c = 0; c < cols; c++) {
+            const int x1 = std::max(0, c - rad), x2 = std::min(cols, c + rad + 1);
+            const double *p22 = sums.ptr<double>(y2) + x2 * TERMS, *p12 = sums.ptr<double>(y1) + x2 * TERMS;
+            const double *p21 = sums.ptr<double>(y2) + x1 * TERMS, *p11 = sums.ptr<double>(y1) + x1 * TERMS;
+            double s[TERMS];
+            for (int k = 0; k < TERMS; k++) s[k] = p22[k] - p12[k] - p21[k] + p11[k];
+
+            pNormals[c] = cv::Vec3f(0, 0, 1.0f);
+            const double n = s[0];
+            if (n < 3) continue;
+
+            const double mX = s[1] / n, mY = s[2] / n, mZ = s[6] / n;
+            const double cXX = s[3] - n * mX * mX, cYY = s[4] - n * mY * mY, cXY = s[5] - n * mX * mY;
+            const double cXZ = s[7] - n * mX * mZ, cYZ = s[8] - n * mY * mZ;
+            const double det = cXX * cYY - cXY * cXY;
+            if (det <= 1e-6) continue;
+
+            // dz/dx and dz/dy, normal has same component order as Hasher::extractSurfaceNormal
+            const double a = (cYY * cXZ - cXY * cYZ) / det;
+            const double b = (cXX * cYZ - cXY * cXZ) / det;
+            pNormals[c] = cv::normalize(cv::Vec3f(static_cast<float>(-b), static_cast<float>(-a), 1.0f));
+        }
+    }
+}
+
+void NormalEstimator::estimate(const cv::Mat &depth, cv::Mat &normals) const {
+    // Checks
+    assert(!depth.empty());
+    assert(depth.type() == 2); // CV_16UC1
+
+    cv::Mat depthF, valid;
+    depth.convertTo(depthF, CV_32F);
+    cv::compare(depth, 0, valid, cv::CMP_GT);
+    valid.convertTo(valid, CV_8U, 1.0 / 255.0);
+
+    estimate(depthF, valid, normals);
+}
+
+// Getters and setters
+bool NormalEstimator::isPlaneFit() const {
+    return planeFit;
+}
+
+unsigned int NormalEstimator::getRadius() const {
+    return radius;
+}
+
+void NormalEstimator::setPlaneFit(bool planeFit) {
+    this->planeFit = planeFit;
+}
+
+void NormalEstimator::setRadius(unsigned int radius) {
+    assert(radius > 0);
+    this->radius = radius;
+}
@@ -0,0 +1,38 @@
+#ifndef VSB_SEMESTRAL_PROJECT_NORMAL_ESTIMATOR_H
+#define VSB_SEMESTRAL_PROJECT_NORMAL_ESTIMATOR_H
+
+#include <opencv2/core/mat.hpp>
+
+/**
+ * class NormalEstimator
+ *
+ * Estimates surface normals of whole depth image at once by least squares plane fit over
+ * (2 * radius + 1)^2 neighbourhood of each pixel. Sums of valid pixels, their coordinates and depths
+ * needed by the fit are read from integral images, so cost per pixel doesn't depend on radius.
+ * Normals are computed for scene once per frame and for templates once after parsing (Template::srcNormals),
+ * both are shared by hashing and matching. Pixels with less than 3 valid neighbours or degenerate fit get normal (0, 0, 1).
+ */
+class NormalEstimator {
+private:
+    bool planeFit; // Estimate normals by plane fitting, otherwise central differences are used in hashing [false]
+    unsigned int radius; // Radius of plane fit neighbourhood [2]
+public:
+    static const int TERMS; // Number of per pixel terms summed in plane fit
+
+    // Constructors
+    NormalEstimator(bool planeFit = false, unsigned int radius = 2) : planeFit(planeFit), radius(radius) {}
+
+    // Methods
+    void estimate(const cv::Mat &depth, const cv::Mat &valid, cv::Mat &normals) const; // depth CV_32F, valid CV_8U, normals CV_32FC3
+    void estimate(const cv::Mat &depth, cv::Mat &normals) const; // depth CV_16U of templates, zero depth is invalid
+
+    // Getters
+    bool isPlaneFit() const;
+    unsigned int getRadius() const;
+
+    // Setters
+    void setPlaneFit(bool planeFit);
+    void setRadius(unsigned int radius);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_NORMAL_ESTIMATOR_H
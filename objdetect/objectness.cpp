@@ -1,5 +1,7 @@
 #include "objectness.h"
 #include <cassert>
+#include <algorithm>
+#include <unordered_map>
 #include "../utils/utils.h"
 
 void Objectness::filterSobel(cv::Mat &src, cv::Mat &dst) {
@@ -62,39 +64,118 @@ void Objectness::thresholdMinMax(cv::Mat &src, cv::Mat &dst, float minThreshold,
     }
 }
 
-cv::Vec3f Objectness::extractMinEdgels(std::vector<TemplateGroup> &templateGroups) {
+void Objectness::coalesceWindows(std::vector<Window> &windows) {
     // Checks
-    assert(!templateGroups.empty());
+    assert(coalesceRadius > 0);
+
+    // Visit windows from the one with most edgels, so kept windows are local maxima of edgels
+    const int radius = static_cast<int>(coalesceRadius);
+    std::vector<size_t> order(windows.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&windows](size_t a, size_t b) {
+        return windows[a].edgels > windows[b].edgels;
+    });
+
+    // Window is kept if no kept window lies within radius, kept windows are bucketed into cells of radius
+    // size and looked up in 3x3 neighbouring cells, so neighbours across cell borders are found too
+    auto cellKey = [](int cx, int cy) {
+        return (static_cast<long long>(cy) << 32) | static_cast<unsigned int>(cx);
+    };
+    std::unordered_map<long long, std::vector<size_t>> cells;
+    std::vector<size_t> representatives;
+
+    for (auto &&i : order) {
+        const int cx = windows[i].x / radius, cy = windows[i].y / radius;
+        bool covered = false;
+
+        for (int y = cy - 1; y <= cy + 1 && !covered; y++) {
+            for (int x = cx - 1; x <= cx + 1 && !covered; x++) {
+                auto cell = cells.find(cellKey(x, y));
+                if (cell == cells.end()) continue;
+
+                for (auto &&kept : cell->second) {
+                    if (std::abs(windows[kept].x - windows[i].x) <= radius && std::abs(windows[kept].y - windows[i].y) <= radius) {
+                        covered = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!covered) {
+            cells[cellKey(cx, cy)].push_back(i);
+            representatives.push_back(i);
+        }
+    }
+
+    // Keep only representatives (in original order), their neighbourhood is refined in matching
+    std::sort(representatives.begin(), representatives.end());
+    std::vector<Window> coalesced;
+    coalesced.reserve(representatives.size());
+    for (auto &&index : representatives) {
+        coalesced.push_back(windows[index]);
+        coalesced.back().refineRadius = radius;
+    }
+
+    windows.swap(coalesced);
+}
+
+void Objectness::extractEdgels(const cv::Mat &depthNormalized, cv::Mat &dst, int factor) {
+    // Downsample depth, nearest neighbour doesn't mix depths over discontinuities
+    cv::Mat depthPyramid = depthNormalized;
+    if (factor > 1) {
+        cv::Size pyramidSize((depthNormalized.cols + factor - 1) / factor, (depthNormalized.rows + factor - 1) / factor);
+        cv::resize(depthNormalized, depthPyramid, pyramidSize, 0, 0, cv::INTER_NEAREST);
+    }
+
+    // Sobel differences depths factor times farther apart, so thresholds are scaled by the same factor
+    filterSobel(depthPyramid, dst);
+    thresholdMinMax(dst, dst, this->minThreshold * factor, this->maxThreshold * factor);
+}
+
+cv::Vec3f Objectness::extractMinEdgels(TemplateStore &store) {
+    // Checks
+    assert(!store.empty());
 
     // Extract edgels
     int edgels = 0;
-    cv::Vec3i output(INT_MAX, templateGroups[0].templates[0].src.cols, templateGroups[0].templates[0].src.rows);
-    cv::Mat tplSobel, tplIntegral, tplNormalized;
+    cv::Vec3i output(INT_MAX, store.templates[0].src.cols, store.templates[0].src.rows);
+    cv::Mat tplSobel, tplIntegral, tplNormalized, tplPyramidSobel;
+    const int factor = 1 << pyramidLevels;
+    pyramidEdgelsRatio = 1;
 
     // Find template which contains least amount of the edgels and get his bounding box
-    for (auto &group : templateGroups) {
-        for (auto &t : group.templates) {
-            // Normalize input image into <0, 1> values
-            t.srcDepth.convertTo(tplNormalized, CV_32F, 1.0f / 65536.0f);
-
-            // Apply sobel filter and thresholding
-            filterSobel(tplNormalized, tplSobel);
-            thresholdMinMax(tplSobel, tplSobel, this->minThreshold, this->maxThreshold);
-
-            // Compute integral image for easier computation of edgels
-            cv::integral(tplNormalized, tplIntegral, CV_32F);
-            edgels = static_cast<int>(tplIntegral.at<float>(tplIntegral.rows - 1, tplIntegral.cols - 1));
-
-            // Save minimum edgels
-            if (edgels < output[0]) {
-                output[0] = edgels;
-            }
+    for (size_t i = 0; i < store.size(); i++) {
+        const Template &t = store.templates[i];
 
-            // Save smallest object
-            if (t.srcDepth.cols * t.srcDepth.rows < output[1] * output[2]) {
-                output[1] = t.srcDepth.cols;
-                output[2] = t.srcDepth.rows;
-            }
+        // Normalize input image into <0, 1> values
+        t.srcDepth.convertTo(tplNormalized, CV_32F, 1.0f / 65536.0f);
+
+        // Apply sobel filter and thresholding
+        extractEdgels(tplNormalized, tplSobel, 1);
+
+        // Edgels of each template are kept for routing windows to hash indices
+        store.metadata.edgels[i] = static_cast<int>(cv::sum(tplSobel)[0]);
+
+        // Measure how many edgels remain at pyramid level, detection uses the lowest ratio of all templates
+        if (factor > 1 && store.metadata.edgels[i] > 0) {
+            extractEdgels(tplNormalized, tplPyramidSobel, factor);
+            pyramidEdgelsRatio = std::min(pyramidEdgelsRatio, static_cast<float>(cv::sum(tplPyramidSobel)[0] / store.metadata.edgels[i]));
+        }
+
+        // Compute integral image for easier computation of edgels
+        cv::integral(tplNormalized, tplIntegral, CV_32F);
+        edgels = static_cast<int>(tplIntegral.at<float>(tplIntegral.rows - 1, tplIntegral.cols - 1));
+
+        // Save minimum edgels
+        if (edgels < output[0]) {
+            output[0] = edgels;
+        }
+
+        // Save smallest object
+        if (t.srcDepth.cols * t.srcDepth.rows < output[1] * output[2]) {
+            output[1] = t.srcDepth.cols;
+            output[2] = t.srcDepth.rows;
         }
     }
 
@@ -126,45 +207,59 @@ void Objectness::objectness(cv::Mat &sceneGrayscale, cv::Mat &sceneColor, cv::Ma
     cv::Mat resultScene = sceneColor.clone();
 #endif
 
-    // Apply sobel filter and thresholding on normalized Depth scene (<0, 1> px values)
+    // Apply sobel filter and thresholding on normalized Depth scene (<0, 1> px values), downsampled for coarse detection
+    const int factor = 1 << pyramidLevels;
+    assert(factor == 1 || pyramidEdgelsRatio >= 0);
     cv::Mat sceneSobel;
-    filterSobel(sceneDepthNormalized, sceneSobel);
-    thresholdMinMax(sceneSobel, sceneSobel, this->minThreshold, this->maxThreshold);
+    extractEdgels(sceneDepthNormalized, sceneSobel, factor);
 
     // Calculate image integral
     cv::Mat sceneIntegral;
     cv::integral(sceneSobel, sceneIntegral, CV_32F);
 
-    // Init helper variables
+    // Init helper variables, min edgels are rescaled by ratio measured on templates at the same pyramid level
     minEdgels[0] *= matchThresholdFactor;
     int sizeX = static_cast<int>(minEdgels[1] * slidingWindowSizeFactor), sizeY = static_cast<int>(minEdgels[2] * slidingWindowSizeFactor);
+    const float edgelsRatio = (factor > 1) ? pyramidEdgelsRatio : 1.0f;
+    const float minPyramidEdgels = minEdgels[0] * edgelsRatio;
+    const int pyramidSizeX = sizeX / factor, pyramidSizeY = sizeY / factor;
+    const int pyramidStep = std::max<int>(1, step / factor);
 
     // Slide window over scene and calculate edgel count for each overlap
-    for (int y = 0; y < sceneSobel.rows - sizeY; y += step) {
-        for (int x = 0; x < sceneSobel.cols - sizeX; x += step) {
+    for (int y = 0; y < sceneSobel.rows - pyramidSizeY; y += pyramidStep) {
+        for (int x = 0; x < sceneSobel.cols - pyramidSizeX; x += pyramidStep) {
 
             // Calc edgel value in current sliding window with help of image integral
             unsigned int sceneEdgels = static_cast<unsigned int>(
-                sceneIntegral.at<float>(y + sizeY, x + sizeX)
-                - sceneIntegral.at<float>(y, x + sizeX)
-                - sceneIntegral.at<float>(y + sizeY, x)
+                sceneIntegral.at<float>(y + pyramidSizeY, x + pyramidSizeX)
+                - sceneIntegral.at<float>(y, x + pyramidSizeX)
+                - sceneIntegral.at<float>(y + pyramidSizeY, x)
                 + sceneIntegral.at<float>(y, x)
             );
 
-            if (sceneEdgels >= minEdgels[0]) {
-                windows.push_back(Window(x, y, sizeX, sizeY, sceneEdgels));
+            if (sceneEdgels >= minPyramidEdgels) {
+                // Map window back to full resolution
+                int sceneX = x * factor, sceneY = y * factor;
+                if (sceneX + sizeX >= sceneDepthNormalized.cols || sceneY + sizeY >= sceneDepthNormalized.rows) continue;
+
+                windows.push_back(Window(sceneX, sceneY, sizeX, sizeY, static_cast<unsigned int>(sceneEdgels / std::max(edgelsRatio, 1e-3f))));
 #ifndef NDEBUG
-                windowBBs.push_back(cv::Vec4i(x, y, x + sizeX, y + sizeY));
-                cv::rectangle(resultScene, cv::Point(x, y), cv::Point(x + sizeX, y + sizeY), cv::Vec3b(190, 190, 190));
+                windowBBs.push_back(cv::Vec4i(sceneX, sceneY, sceneX + sizeX, sceneY + sizeY));
+                cv::rectangle(resultScene, cv::Point(sceneX, sceneY), cv::Point(sceneX + sizeX, sceneY + sizeY), cv::Vec3b(190, 190, 190));
 #endif
             }
         }
     }
 
+    // Collapse overlapping windows into representatives
+    if (coalesceRadius > 0) {
+        coalesceWindows(windows);
+    }
+
 #ifndef NDEBUG
     // Calculate coordinates of outer BB
-    int minX = sceneSobel.cols, maxX = 0;
-    int minY = sceneSobel.rows, maxY = 0;
+    int minX = sceneDepthNormalized.cols, maxX = 0;
+    int minY = sceneDepthNormalized.rows, maxY = 0;
     for (int i = 0; i < windowBBs.size(); i++) {
         minX = std::min(minX, windowBBs[i][0]);
         minY = std::min(minY, windowBBs[i][1]);
@@ -208,6 +303,14 @@ unsigned int Objectness::getStep() const {
     return step;
 }
 
+unsigned int Objectness::getPyramidLevels() const {
+    return pyramidLevels;
+}
+
+unsigned int Objectness::getCoalesceRadius() const {
+    return coalesceRadius;
+}
+
 void Objectness::setMinThreshold(float minThreshold) {
     assert(minThreshold >= 0);
     this->minThreshold = minThreshold;
@@ -231,3 +334,12 @@ void Objectness::setStep(unsigned int step) {
     assert(step > 0);
     this->step = step;
 }
+
+void Objectness::setPyramidLevels(unsigned int pyramidLevels) {
+    assert(pyramidLevels <= 4);
+    this->pyramidLevels = pyramidLevels;
+}
+
+void Objectness::setCoalesceRadius(unsigned int coalesceRadius) {
+    this->coalesceRadius = coalesceRadius;
+}
@@ -3,7 +3,7 @@
 
 #include <string>
 #include "../core/template.h"
-#include "../core/template_group.h"
+#include "../core/template_store.h"
 #include "../core/window.h"
 
 /**
@@ -15,6 +15,12 @@
  * Then scene is also first run through sobel filter, then thresholded and then using sliding window of saved BB of
  * smalles template, we slide through the thresholded image and look for edgels. We classify sliding window as containing object
  * if it contains at least 30% of edgels in a template containing least amount of them.
+ * With pyramidLevels > 0 whole detection runs on depth scene downsampled 2^pyramidLevels times
+ * and windows are mapped back to full resolution. Sobel thresholds are scaled by the downsampling factor (depth
+ * differences grow with pixel spacing) and min edgels by ratio of edgels measured on templates at both resolutions.
+ * With coalesceRadius > 0 overlapping windows are
+ * suppressed greedily from the one with most edgels, window is kept only if no kept window lies within
+ * coalesceRadius (local maxima of edgels), template position is then refined within this radius in feature matching.
  */
 class Objectness {
 private:
@@ -23,16 +29,23 @@ private:
     float maxThreshold; // Max threshold applied in sobel filtered image thresholding [0.1f]
     float matchThresholdFactor; // Factor used to reduce minEdge for objectness detection to improve occlusion/noise matching [30% -> 0.3f]
     float slidingWindowSizeFactor; // Reduces sliding window size to improve edge detection [1.0f]
+    unsigned int pyramidLevels; // Number of pyramid levels scene is downsampled by before detection, 0 = full resolution [0]
+    unsigned int coalesceRadius; // Radius overlapping windows are coalesced in, 0 = no coalescing [0]
+    float pyramidEdgelsRatio; // Min ratio of template edgels at pyramid level to full resolution, -1 until extractMinEdgels() runs
 
     void filterSobel(cv::Mat &src, cv::Mat &dst);
     void thresholdMinMax(cv::Mat &src, cv::Mat &dst, float minThreshold, float maxThreshold);
+    void extractEdgels(const cv::Mat &depthNormalized, cv::Mat &dst, int factor);
+    void coalesceWindows(std::vector<Window> &windows);
 public:
     // Constructors
-    Objectness(unsigned int step = 5, float minThreshold = 0.01f, float maxThreshold = 0.1f, float matchThresholdFactor = 0.3f, float slidingWindowSizeFactor = 1.0f)
-        : step(step), minThreshold(minThreshold), maxThreshold(maxThreshold), matchThresholdFactor(matchThresholdFactor), slidingWindowSizeFactor(slidingWindowSizeFactor) {}
+    Objectness(unsigned int step = 5, float minThreshold = 0.01f, float maxThreshold = 0.1f, float matchThresholdFactor = 0.3f, float slidingWindowSizeFactor = 1.0f,
+               unsigned int pyramidLevels = 0, unsigned int coalesceRadius = 0)
+        : step(step), minThreshold(minThreshold), maxThreshold(maxThreshold), matchThresholdFactor(matchThresholdFactor), slidingWindowSizeFactor(slidingWindowSizeFactor),
+          pyramidLevels(pyramidLevels), coalesceRadius(coalesceRadius), pyramidEdgelsRatio(-1) {}
 
     // Methods
-    cv::Vec3f extractMinEdgels(std::vector<TemplateGroup> &templateGroups);
+    cv::Vec3f extractMinEdgels(TemplateStore &store);
     void objectness(cv::Mat &sceneGrayscale, cv::Mat &sceneColor, cv::Mat &sceneDepthNormalized, std::vector<Window> &windows, cv::Vec3f minEdgels);
 
     // Getters
@@ -41,6 +54,8 @@ public:
     float getMaxThreshold() const;
     float getMatchThresholdFactor() const;
     float getSlidingWindowSizeFactor() const;
+    unsigned int getPyramidLevels() const;
+    unsigned int getCoalesceRadius() const;
 
     // Setters
     void setStep(unsigned int step);
@@ -48,6 +63,8 @@ public:
     void setMaxThreshold(float maxThreshold);
     void setMatchThresholdFactor(float matchThresholdFactor);
     void setSlidingWindowSizeFactor(float slidingWindowSizeFactor);
+    void setPyramidLevels(unsigned int pyramidLevels);
+    void setCoalesceRadius(unsigned int coalesceRadius);
 };
 
 #endif //VSB_SEMESTRAL_PROJECT_OBJECTNESS_H
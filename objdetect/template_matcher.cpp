@@ -1,15 +1,784 @@
 #include "template_matcher.h"
+#include <cassert>
+#include <unordered_set>
+#include <unordered_map>
+#include "../utils/utils.h"
+
+const size_t TemplateMatcher::BOUND_CHECK_INTERVAL = 8;
+
+void TemplateMatcher::selectFeaturePoints(Template &t) {
+    // Checks
+    assert(!t.src.empty());
+    assert(!t.srcDepth.empty());
+
+    // Collect all object points (foreground pixels with valid depth)
+    std::vector<cv::Point> objectPoints;
+    objectPoints.reserve(t.foregroundArea);
+    for (auto &&span : t.foregroundSpans) {
+        const ushort *pDepth = t.srcDepth.ptr<ushort>(span.y);
+        for (int x = span.x; x < span.x + span.length; x++) {
+            if (pDepth[x] > 0) {
+                objectPoints.push_back(cv::Point(x, span.y));
+            }
+        }
+    }
+
+    // Pick featurePointsCount points spread uniformly over the object
+    t.featurePoints.clear();
+    if (objectPoints.empty()) return;
+
+    const size_t count = std::min<size_t>(featurePointsCount, objectPoints.size());
+    const double stride = objectPoints.size() / static_cast<double>(count);
+    for (size_t i = 0; i < count; i++) {
+        t.featurePoints.push_back(objectPoints[static_cast<size_t>(i * stride)]);
+    }
+}
+
+void TemplateMatcher::orderFeaturePoints(Template &t) {
+    // Points with highest template intensity first, they decrease remaining energy (and score bound) fastest
+    std::stable_sort(t.featurePoints.begin(), t.featurePoints.end(), [&t](const cv::Point &p1, const cv::Point &p2) {
+        return t.src.at<uchar>(p1) > t.src.at<uchar>(p2);
+    });
+
+    // Remaining energy after each point, featureEnergyTail[0] is energy of all points
+    t.featureEnergyTail.assign(t.featurePoints.size() + 1, 0);
+    double energy = 0;
+    for (size_t i = t.featurePoints.size(); i-- > 0;) {
+        energy += SQR(static_cast<double>(t.src.at<uchar>(t.featurePoints[i])));
+        t.featureEnergyTail[i] = static_cast<float>(energy);
+    }
+}
+
+void TemplateMatcher::selectGradientPoints(Template &t, GradientResponse &gradientResponse) {
+    // Checks
+    assert(!t.src.empty());
+
+    // Quantized orientations of template, same quantization as in the scene (intensities in <0, 1>)
+    cv::Mat srcF, quantized;
+    t.src.convertTo(srcF, CV_32F, 1.0f / 255.0f);
+    gradientResponse.quantize(srcF, quantized);
+
+    std::vector<cv::Point> points;
+    for (int y = 0; y < quantized.rows; y++) {
+        const uchar *pQuantized = quantized.ptr<uchar>(y);
+        for (int x = 0; x < quantized.cols; x++) {
+            if (pQuantized[x]) points.push_back(cv::Point(x, y));
+        }
+    }
+
+    // Pick featurePointsCount points spread uniformly over all strong gradients
+    t.gradientPoints.clear();
+    t.gradientOrientations.clear();
+    if (points.empty()) return;
+
+    const size_t count = std::min<size_t>(featurePointsCount, points.size());
+    const double stride = points.size() / static_cast<double>(count);
+    for (size_t i = 0; i < count; i++) {
+        const cv::Point &point = points[static_cast<size_t>(i * stride)];
+        t.gradientPoints.push_back(point);
+        t.gradientOrientations.push_back(static_cast<uchar>(__builtin_ctz(quantized.at<uchar>(point))));
+    }
+}
+
+float TemplateMatcher::matchFeaturePoints(const cv::Mat &srcGrayscale, const Template &t, cv::Point tl, float scale, float bound) {
+    float sum = 0, sumNormT = 0, sumNormI = 0;
+    const bool bounded = earlyTermination && bound > 0 && t.featureEnergyTail.size() == t.featurePoints.size() + 1
+                         && t.featureEnergyTail[0] > 0;
+    const float boundSqr = SQR(bound);
+
+    // Normalized cross correlation over rescaled feature points, raw 8-bit template intensities
+    // are used since correlation is invariant to scaling of template values
+    for (size_t i = 0; i < t.featurePoints.size(); i++) {
+        const cv::Point &point = t.featurePoints[i];
+        float Ti = t.src.at<uchar>(point.y, point.x);
+        float Ii = srcGrayscale.at<float>(tl.y + static_cast<int>(point.y * scale), tl.x + static_cast<int>(point.x * scale));
+
+        sum += Ii * Ti;
+        sumNormI += SQR(Ii);
+        sumNormT += SQR(Ti);
+
+        // By Cauchy-Schwarz, final score <= sqrt((sum^2 / sumNormI + remaining template energy) / template energy)
+        // for any intensities of remaining points, returned bound is below given bound as full score would be
+        if (bounded && (i + 1) % BOUND_CHECK_INTERVAL == 0 && sumNormI > 0) {
+            const float upperSqr = (SQR(sum) / sumNormI + t.featureEnergyTail[i + 1]) / t.featureEnergyTail[0];
+            if (upperSqr < boundSqr) return std::sqrt(upperSqr);
+        }
+    }
+
+    if (sumNormI == 0 || sumNormT == 0) return 0;
+    return sum / std::sqrt(sumNormI * sumNormT);
+}
+
+float TemplateMatcher::matchFeaturePointsCoarse(const cv::Mat &srcPyramid, const Template &t, cv::Point tl, float scale) {
+    const int factor = 1 << pyramidLevels;
+    const size_t featureStep = std::min<size_t>(factor, t.featurePoints.size());
+    float sum = 0, sumNormT = 0, sumNormI = 0;
+
+    // Same correlation as in full resolution, only every factor-th feature point is used
+    for (size_t i = 0; i < t.featurePoints.size(); i += featureStep) {
+        const cv::Point &point = t.featurePoints[i];
+        float Ti = t.srcPyramid.at<uchar>(point.y / factor, point.x / factor);
+        float Ii = srcPyramid.at<float>((tl.y + static_cast<int>(point.y * scale)) / factor, (tl.x + static_cast<int>(point.x * scale)) / factor);
+
+        sum += Ii * Ti;
+        sumNormI += SQR(Ii);
+        sumNormT += SQR(Ti);
+    }
+
+    if (sumNormI == 0 || sumNormT == 0) return 0;
+    return sum / std::sqrt(sumNormI * sumNormT);
+}
+
+float TemplateMatcher::searchCoarseLocation(const cv::Mat &srcPyramid, const Template &t, const Window &window, float scale, cv::Point &tl) {
+    // Template must fit into the scene at every searched location
+    const int factor = 1 << pyramidLevels;
+    const int maxX = srcPyramid.cols * factor - 1 - static_cast<int>(t.objBB.width * scale);
+    const int maxY = srcPyramid.rows * factor - 1 - static_cast<int>(t.objBB.height * scale);
+
+    // Locations within refine radius with stride of one pyramid pixel, best one is the start of refinement
+    float best = -1;
+    const int radius = (window.refineRadius / factor) * factor;
+    for (int dy = -radius; dy <= radius; dy += factor) {
+        for (int dx = -radius; dx <= radius; dx += factor) {
+            cv::Point p(window.x + dx, window.y + dy);
+            if (p.x < 0 || p.y < 0 || p.x > maxX || p.y > maxY) continue;
+
+            float score = matchFeaturePointsCoarse(srcPyramid, t, p, scale);
+            if (score > best) {
+                best = score;
+                tl = p;
+            }
+        }
+    }
+
+    return best;
+}
+
+float TemplateMatcher::refineLocation(const cv::Mat &srcGrayscale, const Template &t, const Window &window, float scale, cv::Point &tl) {
+    // Template must fit into the scene at every location within refine radius
+    const int maxX = srcGrayscale.cols - 1 - static_cast<int>(t.objBB.width * scale);
+    const int maxY = srcGrayscale.rows - 1 - static_cast<int>(t.objBB.height * scale);
+
+    float score = matchFeaturePoints(srcGrayscale, t, tl, scale, 0);
+
+    // Hill climbing from tl, move to the best neighbour (halving the step) until no neighbour improves score
+    for (int step = std::max(1, window.refineRadius / 2); step > 0; step /= 2) {
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            cv::Point best = tl;
+
+            for (int dy = -step; dy <= step; dy += step) {
+                for (int dx = -step; dx <= step; dx += step) {
+                    cv::Point p(tl.x + dx, tl.y + dy);
+                    if ((dx == 0 && dy == 0) || p.x < 0 || p.y < 0 || p.x > maxX || p.y > maxY) continue;
+                    if (std::abs(p.x - window.x) > window.refineRadius || std::abs(p.y - window.y) > window.refineRadius) continue;
+
+                    float neighbourScore = matchFeaturePoints(srcGrayscale, t, p, scale, score);
+                    if (neighbourScore > score) {
+                        score = neighbourScore;
+                        best = p;
+                        moved = true;
+                    }
+                }
+            }
+
+            tl = best;
+        }
+    }
+
+    return score;
+}
+
+float TemplateMatcher::searchGradientLocation(const ResponseMaps &srcResponseMaps, const Template &t, const Window &window, float scale, cv::Point &tl) {
+    const int step = srcResponseMaps.step;
+    const int width = static_cast<int>(t.objBB.width * scale), height = static_cast<int>(t.objBB.height * scale);
+
+    // Grid locations within refine radius, whole template must fit into the grid of response maps
+    const int x1 = std::max(0, window.x - window.refineRadius), y1 = std::max(0, window.y - window.refineRadius);
+    const int x2 = std::min(window.x + window.refineRadius, srcResponseMaps.cols * step - 1 - width);
+    const int y2 = std::min(window.y + window.refineRadius, srcResponseMaps.rows * step - 1 - height);
+    if (x2 < x1 || y2 < y1) return -1;
+
+    const int gx1 = (x1 + step - 1) / step, gy1 = (y1 + step - 1) / step, gx2 = x2 / step, gy2 = y2 / step;
+    if (gx2 < gx1 || gy2 < gy1) return -1;
+
+    const int gridCols = gx2 - gx1 + 1, gridRows = gy2 - gy1 + 1, gridSize = gridCols * gridRows;
+    std::vector<uchar> batch(gridSize, 0);
+    std::vector<uint> sums(gridSize, 0);
+
+    // Responses of one point at all grid locations are contiguous rows of its memory, they are summed
+    // into 8-bit accumulators in batches of points (which can't overflow) flushed into 32-bit sums,
+    // so any featurePointsCount is safe
+    const size_t batchSize = 255 / GradientResponse::MAX_RESPONSE;
+    for (size_t i = 0; i < t.gradientPoints.size(); i++) {
+        const cv::Point &point = t.gradientPoints[i];
+        const uchar *pMemory = srcResponseMaps.memory(t.gradientOrientations[i], gx1 * step + static_cast<int>(point.x * scale),
+                                                      gy1 * step + static_cast<int>(point.y * scale));
+
+        for (int gy = 0; gy < gridRows; gy++) {
+            const uchar *pSrc = pMemory + gy * srcResponseMaps.cols;
+            uchar *pBatch = batch.data() + gy * gridCols;
+
+            for (int gx = 0; gx < gridCols; gx++) {
+                pBatch[gx] += pSrc[gx];
+            }
+        }
+
+        if ((i + 1) % batchSize == 0 || i + 1 == t.gradientPoints.size()) {
+            for (int j = 0; j < gridSize; j++) {
+                sums[j] += batch[j];
+            }
+            std::fill(batch.begin(), batch.end(), 0);
+        }
+    }
+
+    // Best grid location
+    const int best = static_cast<int>(std::max_element(sums.begin(), sums.end()) - sums.begin());
+    tl = cv::Point((gx1 + best % gridCols) * step, (gy1 + best / gridCols) * step);
+
+    return sums[best] / static_cast<float>(GradientResponse::MAX_RESPONSE * t.gradientPoints.size());
+}
+
+float TemplateMatcher::matchCandidate(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                                      const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const Template &t, const Window &window,
+                                      cv::Point &tl, float &scale, float &correlation, unsigned long &coarseRejected) {
+    // Correlation stays -1 if template is rejected before it is correlated
+    correlation = -1;
+    if (t.featurePoints.empty()) return -1;
+
+    // Template rendered at distance z appears z / depth times bigger at window depth
+    scale = 1;
+    if (scaleNormalization && window.depth > 0) {
+        scale = t.camTm2c[2] / window.depth;
+        if (scale < minScale || scale > maxScale) return -1;
+    }
+
+    // Skip templates which don't fit into the scene at window location
+    tl = cv::Point(window.x, window.y);
+    if (window.x + t.objBB.width * scale >= srcGrayscale.cols || window.y + t.objBB.height * scale >= srcGrayscale.rows) {
+        return -1;
+    }
+
+    // Dense gradient search within refine radius, hopeless templates are rejected before correlation
+    const bool gradientTest = minGradientScore > 0 && !srcResponseMaps.empty() && !t.gradientPoints.empty();
+    const bool gradientSearch = gradientTest && window.refineRadius > 0;
+    if (gradientSearch) {
+        const float gradientScore = searchGradientLocation(srcResponseMaps, t, window, scale, tl);
+        if (gradientScore >= 0 && gradientScore < minGradientScore) return 0;
+    }
+
+    // Coarse pass at location found by gradient search, otherwise over whole refine neighbourhood (refinement then
+    // starts from the best coarse location), only surviving candidates are matched at full resolution
+    if (!srcPyramid.empty() && !t.srcPyramid.empty()) {
+        const float coarseScore = gradientSearch ? matchFeaturePointsCoarse(srcPyramid, t, tl, scale)
+                                                 : searchCoarseLocation(srcPyramid, t, window, scale, tl);
+        if (coarseScore < coarseMinScore) {
+            coarseRejected++;
+            return 0;
+        }
+    }
+
+    // Refine position of template in coalesced windows
+    float score = (window.refineRadius > 0) ? refineLocation(srcGrayscale, t, window, scale, tl)
+                                            : matchFeaturePoints(srcGrayscale, t, tl, scale, minScore);
+    correlation = score;
+
+    // Verify surface normals of matches (Test II)
+    if (score > minScore && minNormalScore > 0 && !srcNormals.empty() && !t.featureNormals.empty()
+        && testSurfaceNormalOrientation(srcNormals, t, tl, scale) < minNormalScore) {
+        return 0;
+    }
+
+    // Verify gradient orientations of matches (Test III)
+    if (score > minScore && gradientTest && testIntensityGradients(srcResponseMaps, t, tl, scale) < minGradientScore) {
+        return 0;
+    }
+
+    // Verify hue of matches (Test V)
+    if (score > minScore && minColorScore > 0 && !srcHue.empty() && !t.featureHues.empty()
+        && testColor(srcHue, t, tl, scale) < minColorScore) {
+        return 0;
+    }
+
+    return score;
+}
+
+float TemplateMatcher::testSurfaceNormalOrientation(const cv::Mat &srcNormals, const Template &t, cv::Point tl, float scale) {
+    // Checks
+    assert(t.featureNormals.size() == t.featurePoints.size());
+
+    // Mean cosine of angle between template and scene normals at rescaled feature points
+    float sum = 0;
+    for (size_t i = 0; i < t.featurePoints.size(); i++) {
+        const cv::Point &point = t.featurePoints[i];
+        const cv::Vec3f &n = srcNormals.at<cv::Vec3f>(tl.y + static_cast<int>(point.y * scale), tl.x + static_cast<int>(point.x * scale));
+        sum += std::max(0.0f, n.dot(t.featureNormals[i]));
+    }
+
+    return sum / t.featurePoints.size();
+}
+
+float TemplateMatcher::testIntensityGradients(const ResponseMaps &srcResponseMaps, const Template &t, cv::Point tl, float scale) {
+    // Checks
+    assert(static_cast<int>(srcResponseMaps.memories.size()) == GradientResponse::ORIENTATIONS);
+
+    // Response of template orientation at each rescaled gradient point, normalized to <0, 1>
+    int sum = 0;
+    for (size_t i = 0; i < t.gradientPoints.size(); i++) {
+        const cv::Point &point = t.gradientPoints[i];
+        sum += srcResponseMaps.at(t.gradientOrientations[i], tl.x + static_cast<int>(point.x * scale), tl.y + static_cast<int>(point.y * scale));
+    }
+
+    return sum / static_cast<float>(GradientResponse::MAX_RESPONSE * t.gradientPoints.size());
+}
+
+float TemplateMatcher::testColor(const cv::Mat &srcHue, const Template &t, cv::Point tl, float scale) {
+    // Checks
+    assert(t.featureHues.size() == t.featurePoints.size());
+    assert(!hueSimilarity.empty());
+
+    // Ratio of rescaled feature points with similar hue, bins are compared by single lookup
+    int matched = 0;
+    for (size_t i = 0; i < t.featurePoints.size(); i++) {
+        const cv::Point &point = t.featurePoints[i];
+        const uchar hue = srcHue.at<uchar>(tl.y + static_cast<int>(point.y * scale), tl.x + static_cast<int>(point.x * scale));
+        matched += hueSimilarity[t.featureHues[i] * hueBins + hue];
+    }
+
+    return matched / static_cast<float>(t.featurePoints.size());
+}
+
+void TemplateMatcher::searchViewpoints(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                                       const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, const Window &window,
+                                       std::vector<TemplateMatch> &matches, unsigned long &evaluated, unsigned long &coarseRejected) {
+    const std::unordered_set<uint> candidates(window.candidates.begin(), window.candidates.end());
+    std::unordered_set<uint> covered;
+    std::unordered_map<uint, float> scores;
+    std::vector<std::pair<float, uint>> seeds;
+
+    auto evaluate = [&](uint handle) {
+        cv::Point tl;
+        float scale, correlation;
+        float score = matchCandidate(srcGrayscale, srcPyramid, srcNormals, srcResponseMaps, srcHue, store[handle], window, tl, scale, correlation, coarseRejected);
+        scores[handle] = score;
+        evaluated++;
+
+        if (score > minScore) {
+            matches.push_back(TemplateMatch(tl, handle, score, scale));
+        }
+
+        return score;
+    };
+
+    // Sparse pass, each matched view covers its neighbours, so only views not covered yet are matched
+    for (auto &&handle : window.candidates) {
+        if (covered.count(handle)) continue;
+
+        seeds.push_back(std::make_pair(evaluate(handle), handle));
+        covered.insert(handle);
+        covered.insert(viewpointGraph.begin(handle), viewpointGraph.end(handle));
+    }
+
+    // Expand best views, neighbour scoring better than the expanded view is expanded as well
+    const size_t expandCount = std::min<size_t>(viewpointExpandCount, seeds.size());
+    std::partial_sort(seeds.begin(), seeds.begin() + expandCount, seeds.end(), std::greater<std::pair<float, uint>>());
+    seeds.resize(expandCount);
+
+    while (!seeds.empty()) {
+        std::pair<float, uint> view = seeds.back();
+        seeds.pop_back();
+        if (view.first <= 0) continue;
+
+        for (const uint *it = viewpointGraph.begin(view.second); it != viewpointGraph.end(view.second); ++it) {
+            if (!candidates.count(*it) || scores.count(*it)) continue;
+
+            float score = evaluate(*it);
+            if (score > view.first) {
+                seeds.push_back(std::make_pair(score, *it));
+            }
+        }
+    }
+}
+
+void TemplateMatcher::searchTree(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                                 const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, const Window &window,
+                                 std::vector<TemplateMatch> &matches, unsigned long &evaluated, unsigned long &coarseRejected) {
+    // Positions of candidates in tree order, subtree contains candidate if any position falls into its range
+    std::vector<uint> candidatePositions;
+    for (auto &&handle : window.candidates) {
+        candidatePositions.push_back(templateTree.positions[handle]);
+    }
+    std::sort(candidatePositions.begin(), candidatePositions.end());
+
+    auto containsCandidate = [&](uint first, uint last) {
+        auto it = std::lower_bound(candidatePositions.begin(), candidatePositions.end(), first);
+        return it != candidatePositions.end() && *it < last;
+    };
+
+    // Representatives which are not candidates are matched only to estimate score of their subtree, correlation
+    // is returned (-1 if template wasn't correlated), so failed tests of representative don't prune its cluster
+    std::unordered_map<uint, float> correlations;
+    auto evaluate = [&](uint handle) {
+        auto cached = correlations.find(handle);
+        if (cached != correlations.end()) return cached->second;
+
+        cv::Point tl;
+        float scale, correlation;
+        float score = matchCandidate(srcGrayscale, srcPyramid, srcNormals, srcResponseMaps, srcHue, store[handle], window, tl, scale, correlation, coarseRejected);
+        correlations[handle] = correlation;
+        evaluated++;
+
+        const uint position = templateTree.positions[handle];
+        if (score > minScore && containsCandidate(position, position + 1)) {
+            matches.push_back(TemplateMatch(tl, handle, score, scale));
+        }
+
+        return correlation;
+    };
+
+    // Descend trees of all objects, all candidates are matched in reached leaves
+    std::vector<uint> stack;
+    for (auto &&root : templateTree.roots) {
+        if (containsCandidate(templateTree.nodes[root].first, templateTree.nodes[root].last)) stack.push_back(root);
+    }
+
+    while (!stack.empty()) {
+        const uint nodeIndex = stack.back();
+        const TemplateTree::Node &node = templateTree.nodes[nodeIndex];
+        stack.pop_back();
+
+        if (templateTree.isLeaf(nodeIndex)) {
+            for (uint i = node.first; i < node.last; i++) {
+                if (containsCandidate(i, i + 1)) evaluate(templateTree.order[i]);
+            }
+            continue;
+        }
+
+        for (auto &&child : node.children) {
+            const TemplateTree::Node &childNode = templateTree.nodes[child];
+            if (!containsCandidate(childNode.first, childNode.last)) continue;
+
+            // Heuristic pruning, templates of cluster are assumed to score at most treeScoreMargin above its
+            // representative (not a bound), clusters whose representative wasn't correlated are always descended
+            const float correlation = evaluate(childNode.representative);
+            if (correlation < 0 || correlation + treeScoreMargin >= minScore) {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+void TemplateMatcher::train(TemplateStore &store, GradientResponse &gradientResponse,
+                            const HueQuantizer &hueQuantizer) {
+    // Checks
+    assert(!store.empty());
+
+    const int factor = 1 << pyramidLevels;
+    for (auto &&t : store.templates) {
+        selectFeaturePoints(t);
+
+        // Order feature points for early termination before other per point data is extracted
+        if (earlyTermination) {
+            orderFeaturePoints(t);
+        } else {
+            t.featureEnergyTail.clear();
+        }
+
+        // Normals at feature points, estimated after parsing same way as in the scene
+        t.featureNormals.clear();
+        if (!t.srcNormals.empty()) {
+            for (auto &&point : t.featurePoints) {
+                t.featureNormals.push_back(t.srcNormals.at<cv::Vec3f>(point));
+            }
+        }
+
+        // Hue bins at feature points, srcHue is quantized at load time
+        t.featureHues.clear();
+        if (!t.srcHue.empty()) {
+            for (auto &&point : t.featurePoints) {
+                t.featureHues.push_back(t.srcHue.at<uchar>(point));
+            }
+        }
+
+        // Gradient points, quantized same way as the scene
+        if (gradientResponse.isEnabled()) {
+            selectGradientPoints(t, gradientResponse);
+        } else {
+            t.gradientPoints.clear();
+            t.gradientOrientations.clear();
+        }
+
+        // Downsample templates for coarse pass once at load time
+        if (factor > 1) {
+            cv::Size pyramidSize((t.src.cols + factor - 1) / factor, (t.src.rows + factor - 1) / factor);
+            cv::resize(t.src, t.srcPyramid, pyramidSize, 0, 0, cv::INTER_AREA);
+        } else {
+            t.srcPyramid.release();
+        }
+    }
+
+    // Similarity of all pairs of hue bins for color test
+    hueBins = hueQuantizer.getHueBins();
+    hueSimilarity.assign(hueBins * hueBins, 0);
+    for (int b1 = 0; b1 < hueBins; b1++) {
+        for (int b2 = 0; b2 < hueBins; b2++) {
+            hueSimilarity[b1 * hueBins + b2] = static_cast<uchar>(hueQuantizer.distance(b1, b2) <= static_cast<int>(hueTolerance));
+        }
+    }
+
+    // Graph of nearest viewpoints for hierarchical search and tracking
+    if (viewpointNeighbours > 0) {
+        viewpointGraph.build(store, viewpointNeighbours);
+    } else {
+        viewpointGraph.clear();
+    }
+
+    // Viewpoint clusters for tree search
+    if (treeSearch) {
+        templateTree.build(store, treeBranching, treeLeafSize);
+    } else {
+        templateTree.clear();
+    }
+}
+
+void TemplateMatcher::match(const cv::Mat &srcColor, const cv::Mat &srcGrayscale, const cv::Mat &srcDepth, const cv::Mat &srcNormals,
+                            const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, std::vector<Window> &windows,
+                            std::vector<TemplateMatch> &matches) {
+    // Checks
+    assert(!srcGrayscale.empty());
+    assert(srcGrayscale.type() == 5); // CV_32FC1
+    assert(srcNormals.empty() || srcNormals.size() == srcGrayscale.size());
+    assert(srcHue.empty() || srcHue.size() == srcGrayscale.size());
+
+    // Downsample scene for coarse pass
+    const int factor = 1 << pyramidLevels;
+    cv::Mat srcPyramid;
+    if (factor > 1) {
+        cv::Size pyramidSize((srcGrayscale.cols + factor - 1) / factor, (srcGrayscale.rows + factor - 1) / factor);
+        cv::resize(srcGrayscale, srcPyramid, pyramidSize, 0, 0, cv::INTER_AREA);
+    }
+
+    unsigned long coarseRejected = 0, candidatesCount = 0, evaluated = 0;
+    const bool tree = treeSearch && templateTree.size() == store.size();
+    const bool hierarchical = !tree && viewpointSearch && viewpointGraph.size() == store.size();
+    for (auto &&window : windows) {
+        // Skip windows with no candidates
+        if (!window.hasCandidates()) {
+            continue;
+        }
+
+        candidatesCount += window.candidates.size();
+        if (tree) {
+            searchTree(srcGrayscale, srcPyramid, srcNormals, srcResponseMaps, srcHue, store, window, matches, evaluated, coarseRejected);
+            continue;
+        }
+
+        if (hierarchical) {
+            searchViewpoints(srcGrayscale, srcPyramid, srcNormals, srcResponseMaps, srcHue, store, window, matches, evaluated, coarseRejected);
+            continue;
+        }
+
+        for (auto &&handle : window.candidates) {
+            cv::Point tl;
+            float scale, correlation;
+            float score = matchCandidate(srcGrayscale, srcPyramid, srcNormals, srcResponseMaps, srcHue, store[handle], window, tl, scale, correlation, coarseRejected);
+            if (score > minScore) {
+                matches.push_back(TemplateMatch(tl, handle, score, scale));
+            }
+        }
+    }
+
+    if (tree) {
+        std::cout << "  |_ Templates evaluated in tree search: " << evaluated << " for " << candidatesCount << " candidates" << std::endl;
+    }
+    if (hierarchical) {
+        std::cout << "  |_ Candidates evaluated in viewpoint search: " << evaluated << " of " << candidatesCount << std::endl;
+    }
+    if (factor > 1) {
+        std::cout << "  |_ Candidates rejected in coarse pass: " << coarseRejected << std::endl;
+    }
+    std::cout << "  |_ Number of matches found: " << matches.size() << std::endl;
+}
+
+// Getters and setters
+bool TemplateMatcher::isFeatureMatching() const {
+    return featureMatching;
+}
 
 uint TemplateMatcher::getFeaturePointsCount() const {
     return featurePointsCount;
 }
 
+bool TemplateMatcher::isScaleNormalization() const {
+    return scaleNormalization;
+}
+
+float TemplateMatcher::getMinScale() const {
+    return minScale;
+}
+
+float TemplateMatcher::getMaxScale() const {
+    return maxScale;
+}
+
+float TemplateMatcher::getMinScore() const {
+    return minScore;
+}
+
+unsigned int TemplateMatcher::getPyramidLevels() const {
+    return pyramidLevels;
+}
+
+float TemplateMatcher::getCoarseMinScore() const {
+    return coarseMinScore;
+}
+
+uint TemplateMatcher::getViewpointNeighbours() const {
+    return viewpointNeighbours;
+}
+
+bool TemplateMatcher::isViewpointSearch() const {
+    return viewpointSearch;
+}
+
+uint TemplateMatcher::getViewpointExpandCount() const {
+    return viewpointExpandCount;
+}
+
+const ViewpointGraph &TemplateMatcher::getViewpointGraph() const {
+    return viewpointGraph;
+}
+
+bool TemplateMatcher::isTreeSearch() const {
+    return treeSearch;
+}
+
+uint TemplateMatcher::getTreeBranching() const {
+    return treeBranching;
+}
+
+uint TemplateMatcher::getTreeLeafSize() const {
+    return treeLeafSize;
+}
+
+float TemplateMatcher::getTreeScoreMargin() const {
+    return treeScoreMargin;
+}
+
+const TemplateTree &TemplateMatcher::getTemplateTree() const {
+    return templateTree;
+}
+
+float TemplateMatcher::getMinNormalScore() const {
+    return minNormalScore;
+}
+
+float TemplateMatcher::getMinGradientScore() const {
+    return minGradientScore;
+}
+
+float TemplateMatcher::getMinColorScore() const {
+    return minColorScore;
+}
+
+uint TemplateMatcher::getHueTolerance() const {
+    return hueTolerance;
+}
+
+bool TemplateMatcher::isEarlyTermination() const {
+    return earlyTermination;
+}
+
+void TemplateMatcher::setFeatureMatching(bool featureMatching) {
+    this->featureMatching = featureMatching;
+}
+
 void TemplateMatcher::setFeaturePointsCount(uint featurePointsCount) {
     assert(featurePointsCount > 0);
     this->featurePointsCount = featurePointsCount;
 }
 
-void TemplateMatcher::match(const cv::Mat &srcColor, const cv::Mat &srcGrayscale, const cv::Mat &srcDepth,
-                     std::vector<Window> &windows, std::vector<TemplateMatch> &matches) {
+void TemplateMatcher::setScaleNormalization(bool scaleNormalization) {
+    this->scaleNormalization = scaleNormalization;
+}
+
+void TemplateMatcher::setMinScale(float minScale) {
+    assert(minScale > 0);
+    this->minScale = minScale;
+}
+
+void TemplateMatcher::setMaxScale(float maxScale) {
+    assert(maxScale > 0);
+    this->maxScale = maxScale;
+}
+
+void TemplateMatcher::setMinScore(float minScore) {
+    assert(minScore >= 0 && minScore <= 1);
+    this->minScore = minScore;
+}
+
+void TemplateMatcher::setPyramidLevels(unsigned int pyramidLevels) {
+    assert(pyramidLevels <= 4);
+    this->pyramidLevels = pyramidLevels;
+}
+
+void TemplateMatcher::setCoarseMinScore(float coarseMinScore) {
+    assert(coarseMinScore >= 0 && coarseMinScore <= 1);
+    this->coarseMinScore = coarseMinScore;
+}
+
+void TemplateMatcher::setViewpointNeighbours(uint viewpointNeighbours) {
+    this->viewpointNeighbours = viewpointNeighbours;
+}
+
+void TemplateMatcher::setViewpointSearch(bool viewpointSearch) {
+    this->viewpointSearch = viewpointSearch;
+}
+
+void TemplateMatcher::setViewpointExpandCount(uint viewpointExpandCount) {
+    assert(viewpointExpandCount > 0);
+    this->viewpointExpandCount = viewpointExpandCount;
+}
+
+void TemplateMatcher::setTreeSearch(bool treeSearch) {
+    this->treeSearch = treeSearch;
+}
+
+void TemplateMatcher::setTreeBranching(uint treeBranching) {
+    assert(treeBranching > 1);
+    this->treeBranching = treeBranching;
+}
+
+void TemplateMatcher::setTreeLeafSize(uint treeLeafSize) {
+    assert(treeLeafSize > 0);
+    this->treeLeafSize = treeLeafSize;
+}
+
+void TemplateMatcher::setTreeScoreMargin(float treeScoreMargin) {
+    assert(treeScoreMargin >= 0);
+    this->treeScoreMargin = treeScoreMargin;
+}
+
+void TemplateMatcher::setMinNormalScore(float minNormalScore) {
+    assert(minNormalScore >= 0 && minNormalScore <= 1);
+    this->minNormalScore = minNormalScore;
+}
+
+void TemplateMatcher::setMinGradientScore(float minGradientScore) {
+    assert(minGradientScore >= 0 && minGradientScore <= 1);
+    this->minGradientScore = minGradientScore;
+}
+
+void TemplateMatcher::setMinColorScore(float minColorScore) {
+    assert(minColorScore >= 0 && minColorScore <= 1);
+    this->minColorScore = minColorScore;
+}
+
+void TemplateMatcher::setHueTolerance(uint hueTolerance) {
+    this->hueTolerance = hueTolerance;
+}
 
+void TemplateMatcher::setEarlyTermination(bool earlyTermination) {
+    this->earlyTermination = earlyTermination;
 }
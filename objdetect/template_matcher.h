@@ -5,30 +5,141 @@
 #include <opencv2/core/mat.hpp>
 #include "../core/window.h"
 #include "../core/template_match.h"
+#include "../core/template_store.h"
+#include "../core/viewpoint_graph.h"
+#include "../core/template_tree.h"
+#include "gradient_response.h"
+#include "hue_quantizer.h"
 
+/**
+ * class TemplateMatcher
+ *
+ * Final stage of verification, matches candidates of each window by normalized cross correlation
+ * over sparse set of feature points selected in each template. Candidates can be searched over
+ * viewpoint graph or template tree instead of one by one, matches are then verified by optional
+ * tests of surface normals (II), gradient orientations (III) and hue (V).
+ */
 class TemplateMatcher {
 private:
-    uint featurePointsCount;
+    bool featureMatching; // Match sparse feature points, dense correlation of whole templates is used otherwise [false]
+    uint featurePointsCount; // Number of feature points spread over each template object [100]
+    bool scaleNormalization; // Rescale feature points by template rendering distance / window depth [false]
+    float minScale; // Templates needing smaller scale are skipped [0.5f]
+    float maxScale; // Templates needing bigger scale are skipped [2.0f]
+    float minScore; // Min correlation of a match [0.5f]
+    unsigned int pyramidLevels; // Coarse pass on images downsampled 2^pyramidLevels times, 0 = off [0]
+    float coarseMinScore; // Min correlation in coarse pass, searched over whole refine radius [0.4f]
+    uint viewpointNeighbours; // Number of nearest views linked to each template in viewpoint graph [8]
+    bool viewpointSearch; // Match sparse cover of viewpoint graph first, then neighbours of best views [false]
+    uint viewpointExpandCount; // Number of best views whose neighbours are matched in viewpoint search [3]
+    ViewpointGraph viewpointGraph;
+    bool treeSearch; // Descend viewpoint clusters of each object instead of matching candidates one by one [false]
+    uint treeBranching; // Number of children of each tree node [4]
+    uint treeLeafSize; // Max number of templates in tree leaf [8]
+    float treeScoreMargin; // Cluster is skipped if representative correlation + margin < minScore (heuristic, not a bound) [0.1f]
+    TemplateTree templateTree;
+    float minNormalScore; // Min mean cosine of template and scene normals (Test II), 0 = off [0]
+    float minGradientScore; // Min normalized gradient orientation response (Test III, LINE-MOD), 0 = off [0]
+    float minColorScore; // Min ratio of feature points with similar hue (Test V), 0 = off [0]
+    uint hueTolerance; // Max distance of similar hue bins [1]
+    int hueBins;
+    std::vector<uchar> hueSimilarity; // hueSimilarity[bin1 * hueBins + bin2] is 1 if bins are within hueTolerance
+    bool earlyTermination; // Order feature points by energy and abort correlation once its upper bound can't win [false]
+
+    // Methods
+    void selectFeaturePoints(Template &t);
+    void orderFeaturePoints(Template &t);
+    float matchFeaturePoints(const cv::Mat &srcGrayscale, const Template &t, cv::Point tl, float scale, float bound);
+    float matchFeaturePointsCoarse(const cv::Mat &srcPyramid, const Template &t, cv::Point tl, float scale);
+    float searchCoarseLocation(const cv::Mat &srcPyramid, const Template &t, const Window &window, float scale, cv::Point &tl);
+    float refineLocation(const cv::Mat &srcGrayscale, const Template &t, const Window &window, float scale, cv::Point &tl);
+    float searchGradientLocation(const ResponseMaps &srcResponseMaps, const Template &t, const Window &window, float scale, cv::Point &tl);
+    void selectGradientPoints(Template &t, GradientResponse &gradientResponse);
+    float matchCandidate(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                         const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const Template &t, const Window &window,
+                         cv::Point &tl, float &scale, float &correlation, unsigned long &coarseRejected);
+    void searchViewpoints(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                          const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, const Window &window,
+                          std::vector<TemplateMatch> &matches, unsigned long &evaluated, unsigned long &coarseRejected);
+    void searchTree(const cv::Mat &srcGrayscale, const cv::Mat &srcPyramid, const cv::Mat &srcNormals,
+                    const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, const Window &window,
+                    std::vector<TemplateMatch> &matches, unsigned long &evaluated, unsigned long &coarseRejected);
 
     // Tests
     inline bool testObjectSize(); // Test I
-    inline float testSurfaceNormalOrientation(); // Test II
-    inline float testIntensityGradients(); // Test III
+    float testSurfaceNormalOrientation(const cv::Mat &srcNormals, const Template &t, cv::Point tl, float scale); // Test II
+    float testIntensityGradients(const ResponseMaps &srcResponseMaps, const Template &t, cv::Point tl, float scale); // Test III
     inline float testDepth(); // Test IV
-    inline float testColor(); // Test V
+    float testColor(const cv::Mat &srcHue, const Template &t, cv::Point tl, float scale); // Test V
 public:
+    static const size_t BOUND_CHECK_INTERVAL;
+
     // Constructor
-    TemplateMatcher(uint featurePointsCount = 100) : featurePointsCount(featurePointsCount) {}
+    TemplateMatcher(bool featureMatching = false, uint featurePointsCount = 100, bool scaleNormalization = false, float minScale = 0.5f,
+                    float maxScale = 2.0f, float minScore = 0.5f, unsigned int pyramidLevels = 0, float coarseMinScore = 0.4f,
+                    uint viewpointNeighbours = 8, bool viewpointSearch = false, uint viewpointExpandCount = 3,
+                    bool treeSearch = false, uint treeBranching = 4, uint treeLeafSize = 8, float treeScoreMargin = 0.1f,
+                    float minNormalScore = 0, float minGradientScore = 0, float minColorScore = 0, uint hueTolerance = 1,
+                    bool earlyTermination = false)
+        : featureMatching(featureMatching), featurePointsCount(featurePointsCount), scaleNormalization(scaleNormalization), minScale(minScale),
+          maxScale(maxScale), minScore(minScore), pyramidLevels(pyramidLevels), coarseMinScore(coarseMinScore),
+          viewpointNeighbours(viewpointNeighbours), viewpointSearch(viewpointSearch), viewpointExpandCount(viewpointExpandCount),
+          treeSearch(treeSearch), treeBranching(treeBranching), treeLeafSize(treeLeafSize), treeScoreMargin(treeScoreMargin),
+          minNormalScore(minNormalScore), minGradientScore(minGradientScore), minColorScore(minColorScore),
+          hueTolerance(hueTolerance), hueBins(0), earlyTermination(earlyTermination) {}
 
     // Methods
-    void match(const cv::Mat &srcColor, const cv::Mat &srcGrayscale, const cv::Mat &srcDepth,
-               std::vector<Window> &windows, std::vector<TemplateMatch> &matches);
+    void train(TemplateStore &store, GradientResponse &gradientResponse,
+               const HueQuantizer &hueQuantizer);
+    void match(const cv::Mat &srcColor, const cv::Mat &srcGrayscale, const cv::Mat &srcDepth, const cv::Mat &srcNormals,
+               const ResponseMaps &srcResponseMaps, const cv::Mat &srcHue, const TemplateStore &store, std::vector<Window> &windows,
+               std::vector<TemplateMatch> &matches);
 
     // Getters
+    bool isFeatureMatching() const;
     uint getFeaturePointsCount() const;
+    bool isScaleNormalization() const;
+    float getMinScale() const;
+    float getMaxScale() const;
+    float getMinScore() const;
+    unsigned int getPyramidLevels() const;
+    float getCoarseMinScore() const;
+    uint getViewpointNeighbours() const;
+    bool isViewpointSearch() const;
+    uint getViewpointExpandCount() const;
+    const ViewpointGraph &getViewpointGraph() const;
+    bool isTreeSearch() const;
+    uint getTreeBranching() const;
+    uint getTreeLeafSize() const;
+    float getTreeScoreMargin() const;
+    const TemplateTree &getTemplateTree() const;
+    float getMinNormalScore() const;
+    float getMinGradientScore() const;
+    float getMinColorScore() const;
+    uint getHueTolerance() const;
+    bool isEarlyTermination() const;
 
     // Setters
+    void setFeatureMatching(bool featureMatching);
     void setFeaturePointsCount(uint featurePointsCount);
+    void setScaleNormalization(bool scaleNormalization);
+    void setMinScale(float minScale);
+    void setMaxScale(float maxScale);
+    void setMinScore(float minScore);
+    void setPyramidLevels(unsigned int pyramidLevels);
+    void setCoarseMinScore(float coarseMinScore);
+    void setViewpointNeighbours(uint viewpointNeighbours);
+    void setViewpointSearch(bool viewpointSearch);
+    void setViewpointExpandCount(uint viewpointExpandCount);
+    void setTreeSearch(bool treeSearch);
+    void setTreeBranching(uint treeBranching);
+    void setTreeLeafSize(uint treeLeafSize);
+    void setTreeScoreMargin(float treeScoreMargin);
+    void setMinNormalScore(float minNormalScore);
+    void setMinGradientScore(float minGradientScore);
+    void setMinColorScore(float minColorScore);
+    void setHueTolerance(uint hueTolerance);
+    void setEarlyTermination(bool earlyTermination);
 };
 
 #endif //VSB_SEMESTRAL_PROJECT_TEMPLATE_MATCHER_H
@@ -0,0 +1,93 @@
+#include "tracker.h"
+#include <cassert>
+#include <algorithm>
+
+bool Tracker::needsDetection() const {
+    return !enabled || tracks.empty() || framesSinceDetection >= redetectInterval;
+}
+
+void Tracker::seedWindows(const TemplateStore &store, const ViewpointGraph &graph, std::vector<Window> &windows) {
+    // Checks
+    assert(!tracks.empty());
+
+    for (auto &&track : tracks) {
+        const Template &t = store[track.handle];
+
+        // Window at previous location, depth is restored from previous scale so matcher keeps the same scale
+        Window window(track.tl.x, track.tl.y, static_cast<int>(t.objBB.width * track.scale), static_cast<int>(t.objBB.height * track.scale));
+        window.depth = t.camTm2c[2] / track.scale;
+        window.refineRadius = searchRadius;
+
+        // Candidates are matched template and its neighbouring viewpoints (if graph was built)
+        window.candidates.push_back(track.handle);
+        if (graph.size() == store.size()) {
+            const uint *first = graph.begin(track.handle);
+            const uint *last = std::min(graph.end(track.handle), first + neighbourCount);
+            window.candidates.insert(window.candidates.end(), first, last);
+        }
+
+        windows.push_back(window);
+    }
+}
+
+void Tracker::update(const TemplateStore &store, const std::vector<TemplateMatch> &matches, const std::vector<cv::Rect> &matchBBs, bool detected) {
+    // Best match of each detection (BB picked by non-maxima suppression) is tracked in the next frame,
+    // no detections mean track loss
+    tracks.clear();
+    for (auto &&bB : matchBBs) {
+        const TemplateMatch *best = nullptr;
+        for (auto &&match : matches) {
+            const Template &t = store[match.handle];
+            cv::Rect matchBB(match.tl.x, match.tl.y, cvRound(t.objBB.width * match.scale), cvRound(t.objBB.height * match.scale));
+            if (matchBB == bB && (!best || match.score > best->score)) best = &match;
+        }
+
+        if (best) tracks.push_back(*best);
+    }
+
+    framesSinceDetection = detected ? 1 : framesSinceDetection + 1;
+}
+
+void Tracker::reset() {
+    tracks.clear();
+    framesSinceDetection = 0;
+}
+
+// Getters and setters
+bool Tracker::isEnabled() const {
+    return enabled;
+}
+
+unsigned int Tracker::getRedetectInterval() const {
+    return redetectInterval;
+}
+
+int Tracker::getSearchRadius() const {
+    return searchRadius;
+}
+
+unsigned int Tracker::getNeighbourCount() const {
+    return neighbourCount;
+}
+
+const std::vector<TemplateMatch> &Tracker::getTracks() const {
+    return tracks;
+}
+
+void Tracker::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void Tracker::setRedetectInterval(unsigned int redetectInterval) {
+    assert(redetectInterval > 0);
+    this->redetectInterval = redetectInterval;
+}
+
+void Tracker::setSearchRadius(int searchRadius) {
+    assert(searchRadius >= 0);
+    this->searchRadius = searchRadius;
+}
+
+void Tracker::setNeighbourCount(unsigned int neighbourCount) {
+    this->neighbourCount = neighbourCount;
+}
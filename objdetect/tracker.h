@@ -0,0 +1,55 @@
+#ifndef VSB_SEMESTRAL_PROJECT_TRACKER_H
+#define VSB_SEMESTRAL_PROJECT_TRACKER_H
+
+#include <vector>
+#include "../core/template_store.h"
+#include "../core/template_match.h"
+#include "../core/window.h"
+#include "../core/viewpoint_graph.h"
+
+/**
+ * class Tracker
+ *
+ * Frame to frame tracking for video streams, where consecutive frames differ only a little.
+ * Matches of previous frame seed the search in the next one, windows are created only around
+ * previous detections and their candidates are limited to the matched template and its nearest
+ * viewpoints in viewpoint graph. Only the best match of each object surviving non-maxima suppression is
+ * tracked, so the number of tracks doesn't grow between detections. Full detection (objectness + hashing) is run every
+ * redetectInterval frames or when all tracks are lost.
+ */
+class Tracker {
+private:
+    bool enabled;
+    unsigned int redetectInterval; // Full detection is run every redetectInterval frames [10]
+    int searchRadius; // Radius around previous match, where template position is refined [10]
+    unsigned int neighbourCount; // Max number of nearest viewpoints (from viewpoint graph) added to each track candidates [8]
+
+    std::vector<TemplateMatch> tracks;
+    unsigned int framesSinceDetection;
+public:
+    // Constructors
+    Tracker(bool enabled = false, unsigned int redetectInterval = 10, int searchRadius = 10, unsigned int neighbourCount = 8)
+        : enabled(enabled), redetectInterval(redetectInterval), searchRadius(searchRadius), neighbourCount(neighbourCount),
+          framesSinceDetection(0) {}
+
+    // Methods
+    bool needsDetection() const;
+    void seedWindows(const TemplateStore &store, const ViewpointGraph &graph, std::vector<Window> &windows);
+    void update(const TemplateStore &store, const std::vector<TemplateMatch> &matches, const std::vector<cv::Rect> &matchBBs, bool detected);
+    void reset();
+
+    // Getters
+    bool isEnabled() const;
+    unsigned int getRedetectInterval() const;
+    int getSearchRadius() const;
+    unsigned int getNeighbourCount() const;
+    const std::vector<TemplateMatch> &getTracks() const;
+
+    // Setters
+    void setEnabled(bool enabled);
+    void setRedetectInterval(unsigned int redetectInterval);
+    void setSearchRadius(int searchRadius);
+    void setNeighbourCount(unsigned int neighbourCount);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_TRACKER_H
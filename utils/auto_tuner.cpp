@@ -0,0 +1,368 @@
+#include "auto_tuner.h"
+#include <cassert>
+#include "timer.h"
+
+void AutoTuner::loadValidationScenes(Classifier &classifier, std::vector<ValidationScene> &scenes) {
+    // Checks
+    assert(!sceneIndices.empty());
+
+    classifier.setScenePath(scenePath);
+    for (auto &&index : sceneIndices) {
+        // Create scene name from index
+        std::stringstream ss;
+        ss << std::setw(4) << std::setfill('0') << index << ".png";
+        classifier.setSceneName(ss.str());
+
+        // Load scene only once, converted images are restored before each detection. Images are deep copied,
+        // next loadScene() reuses classifier buffers of the same size and type
+        ValidationScene validationScene;
+        classifier.loadScene();
+        validationScene.scene = classifier.getScene().clone();
+        validationScene.sceneGrayscale = classifier.getSceneGrayscale().clone();
+        validationScene.sceneDepth = classifier.getSceneDepth().clone();
+        validationScene.sceneDepthNormalized = classifier.getSceneDepthNormalized().clone();
+        validationScene.sceneDepthValid = classifier.getSceneDepthValid().clone();
+        validationScene.sceneNormals = classifier.getSceneNormals().clone();
+        validationScene.sceneResponseMaps = classifier.getSceneResponseMaps().clone();
+        validationScene.sceneHue = classifier.getSceneHue().clone();
+        loadGroundTruth(classifier, index, validationScene.groundTruth);
+
+        scenes.push_back(validationScene);
+    }
+}
+
+void AutoTuner::loadGroundTruth(Classifier &classifier, int index, std::vector<cv::Rect> &groundTruth) {
+    // Load scene_gt
+    cv::FileStorage fs;
+    fs.open(classifier.getBasePath() + scenePath + "scene_gt.yml", cv::FileStorage::READ);
+    assert(fs.isOpened());
+
+    // Objects ids contained in trained templates (folder names are object ids)
+    std::vector<int> objIds;
+    for (auto &&folder : classifier.getTemplateFolders()) {
+        objIds.push_back(std::stoi(folder));
+    }
+
+    // Parse bounding boxes of trained objects only
+    cv::FileNode sceneNode = fs[std::to_string(index)];
+    for (int i = 0; i < static_cast<int>(sceneNode.size()); i++) {
+        std::vector<int> vObjBB;
+        int objId;
+
+        sceneNode[i]["obj_bb"] >> vObjBB;
+        sceneNode[i]["obj_id"] >> objId;
+        assert(vObjBB.size() == 4);
+
+        if (std::find(objIds.begin(), objIds.end(), objId) != objIds.end()) {
+            groundTruth.push_back(cv::Rect(vObjBB[0], vObjBB[1], vObjBB[2], vObjBB[3]));
+        }
+    }
+
+    fs.release();
+}
+
+int AutoTuner::countFound(const std::vector<cv::Rect> &matchBBs, const std::vector<cv::Rect> &groundTruth) {
+    int found = 0;
+
+    // Ground truth object is found if any of matched BBs overlaps it enough
+    for (auto &&gt : groundTruth) {
+        for (auto &&bB : matchBBs) {
+            float intersection = static_cast<float>((gt & bB).area());
+            float overlap = intersection / (gt.area() + bB.area() - intersection);
+
+            if (overlap >= minOverlap) {
+                found++;
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+void AutoTuner::extractParetoFront(std::vector<TuningParams> &results, std::vector<TuningParams> &front) {
+    // Sort by latency (ASC), configurations with same latency by recall (DESC)
+    std::sort(results.begin(), results.end(), [](const TuningParams &a, const TuningParams &b) {
+        return a.latency < b.latency || (a.latency == b.latency && a.recall > b.recall);
+    });
+
+    // Configuration is pareto-optimal if no other configuration dominates it, front keeps latency order
+    for (auto &&params : results) {
+        bool dominated = false;
+        for (auto &&other : results) {
+            if (other.dominates(params)) {
+                dominated = true;
+                break;
+            }
+        }
+
+        if (!dominated) {
+            front.push_back(params);
+        }
+    }
+}
+
+void AutoTuner::apply(const TuningParams &params, Classifier &classifier) {
+    // Objectness
+    classifier.objectness.setStep(params.step);
+    classifier.objectness.setMinThreshold(params.minThreshold);
+    classifier.objectness.setMaxThreshold(params.maxThreshold);
+
+    // Hasher
+    classifier.hasher.setHashTableCount(params.hashTableCount);
+    classifier.hasher.setHistogramBinCount(params.histogramBinCount);
+    classifier.hasher.setMaxTripletDistance(params.maxTripletDistance);
+    classifier.hasher.setMinVotesPerTemplate(params.minVotesPerTemplate);
+}
+
+TuningParams AutoTuner::load(const std::string &fileName, int index) {
+    // Load tuning results
+    cv::FileStorage fs;
+    fs.open(fileName, cv::FileStorage::READ);
+    assert(fs.isOpened());
+
+    cv::FileNode configurations = fs["configurations"];
+    assert(configurations.size() > 0);
+
+    // Load best configuration if index was not specified, fastest one if none met recall floor
+    if (index < 0) {
+        fs["best"] >> index;
+        index = std::max(index, 0);
+    }
+
+    assert(index < static_cast<int>(configurations.size()));
+    TuningParams params;
+    params.read(configurations[index]);
+    fs.release();
+
+    return params;
+}
+
+void AutoTuner::tune(Classifier &classifier, std::vector<TuningParams> &front) {
+    // Checks
+    assert(!steps.empty());
+    assert(!thresholds.empty());
+    assert(!hashTableCounts.empty());
+    assert(!histogramBinCounts.empty());
+    assert(!maxTripletDistances.empty());
+    assert(!minVotesPerTemplate.empty());
+
+    // Save scene settings to restore them after tuning
+    const std::string originalScenePath = classifier.getScenePath();
+    const std::string originalSceneName = classifier.getSceneName();
+
+    // Load validation scenes and their ground truth
+    std::cout << "Auto tuning started... " << std::endl;
+    std::vector<ValidationScene> scenes;
+    loadValidationScenes(classifier, scenes);
+
+    int groundTruthCount = 0;
+    for (auto &&scene : scenes) {
+        groundTruthCount += scene.groundTruth.size();
+    }
+    assert(groundTruthCount > 0);
+
+    // Parse templates only once, they're shared by all configurations
+    if (classifier.templateStore.empty()) {
+        classifier.parseTemplates();
+    }
+
+    std::vector<TuningParams> results;
+    for (auto &&hashTableCount : hashTableCounts) {
+        for (auto &&histogramBinCount : histogramBinCounts) {
+            for (auto &&maxTripletDistance : maxTripletDistances) {
+                // Train hash tables once for all detection params
+                classifier.hasher.setHashTableCount(hashTableCount);
+                classifier.hasher.setHistogramBinCount(histogramBinCount);
+                classifier.hasher.setMaxTripletDistance(maxTripletDistance);
+                classifier.trainHashTables();
+
+                for (auto &&threshold : thresholds) {
+                    // Min edgels, template edgels, pyramid edgels ratio and index signatures depend on thresholds,
+                    // they're extracted once for all configurations sharing this pair and trained hash tables
+                    classifier.objectness.setMinThreshold(threshold[0]);
+                    classifier.objectness.setMaxThreshold(threshold[1]);
+                    classifier.extractMinEdgels();
+
+                    // Init configurations sharing thresholds and trained hash tables
+                    std::vector<TuningParams> configurations;
+                    for (auto &&step : steps) {
+                        for (auto &&votes : minVotesPerTemplate) {
+                            configurations.push_back(TuningParams(step, threshold[0], threshold[1], hashTableCount,
+                                                                  histogramBinCount, maxTripletDistance, votes));
+                        }
+                    }
+
+                    // Run detection of each configuration on each scene
+                    std::vector<int> found(configurations.size(), 0);
+                    for (auto &&scene : scenes) {
+                        classifier.setScene(scene.scene);
+                        classifier.setSceneGrayscale(scene.sceneGrayscale);
+                        classifier.setSceneDepth(scene.sceneDepth);
+                        classifier.setSceneDepthNormalized(scene.sceneDepthNormalized);
+                        classifier.setSceneDepthValid(scene.sceneDepthValid);
+                        classifier.setSceneNormals(scene.sceneNormals);
+                        classifier.setSceneResponseMaps(scene.sceneResponseMaps);
+                        classifier.setSceneHue(scene.sceneHue);
+
+                        for (int i = 0; i < configurations.size(); i++) {
+                            apply(configurations[i], classifier);
+
+                            Timer t;
+                            classifier.detect();
+                            configurations[i].latency += t.elapsed();
+                            found[i] += countFound(classifier.getMatchBBs(), scene.groundTruth);
+                        }
+                    }
+
+                    // Average measured values
+                    for (int i = 0; i < configurations.size(); i++) {
+                        configurations[i].latency /= scenes.size();
+                        configurations[i].recall = found[i] / static_cast<float>(groundTruthCount);
+                        results.push_back(configurations[i]);
+                        std::cout << "  |_ " << configurations[i] << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    // Pick pareto-optimal configurations
+    extractParetoFront(results, front);
+    std::cout << "DONE! " << results.size() << " configurations evaluated, " << front.size() << " pareto-optimal:" << std::endl;
+    for (int i = 0; i < front.size(); i++) {
+        std::cout << "  |_ " << i << ". " << front[i] << std::endl;
+    }
+    std::cout << std::endl;
+
+    // Restore scene settings
+    classifier.setScenePath(originalScenePath);
+    classifier.setSceneName(originalSceneName);
+}
+
+int AutoTuner::selectBest(const std::vector<TuningParams> &front) const {
+    // Front is sorted by latency, first configuration meeting recall floor is the fastest one
+    for (int i = 0; i < front.size(); i++) {
+        if (front[i].recall >= minRecall) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void AutoTuner::save(const std::string &fileName, const std::vector<TuningParams> &front) const {
+    // Checks
+    assert(!front.empty());
+
+    cv::FileStorage fs;
+    fs.open(fileName, cv::FileStorage::WRITE);
+    assert(fs.isOpened());
+
+    // Save recall floor and index of best configuration
+    fs << "minRecall" << minRecall;
+    fs << "best" << selectBest(front);
+
+    // Save pareto-optimal configurations
+    fs << "configurations" << "[";
+    for (auto &&params : front) {
+        fs << "{";
+        params.write(fs);
+        fs << "}";
+    }
+    fs << "]";
+
+    fs.release();
+}
+
+// Getters and setters
+const std::string &AutoTuner::getScenePath() const {
+    return scenePath;
+}
+
+const std::vector<int> &AutoTuner::getSceneIndices() const {
+    return sceneIndices;
+}
+
+float AutoTuner::getMinRecall() const {
+    return minRecall;
+}
+
+float AutoTuner::getMinOverlap() const {
+    return minOverlap;
+}
+
+const std::vector<unsigned int> &AutoTuner::getSteps() const {
+    return steps;
+}
+
+const std::vector<cv::Vec2f> &AutoTuner::getThresholds() const {
+    return thresholds;
+}
+
+const std::vector<unsigned int> &AutoTuner::getHashTableCounts() const {
+    return hashTableCounts;
+}
+
+const std::vector<unsigned int> &AutoTuner::getHistogramBinCounts() const {
+    return histogramBinCounts;
+}
+
+const std::vector<unsigned int> &AutoTuner::getMaxTripletDistances() const {
+    return maxTripletDistances;
+}
+
+const std::vector<int> &AutoTuner::getMinVotesPerTemplate() const {
+    return minVotesPerTemplate;
+}
+
+void AutoTuner::setScenePath(const std::string &scenePath) {
+    assert(scenePath.length() > 0);
+    assert(scenePath[scenePath.length() - 1] == '/');
+    this->scenePath = scenePath;
+}
+
+void AutoTuner::setSceneIndices(const std::vector<int> &sceneIndices) {
+    assert(!sceneIndices.empty());
+    this->sceneIndices = sceneIndices;
+}
+
+void AutoTuner::setMinRecall(float minRecall) {
+    assert(minRecall >= 0 && minRecall <= 1);
+    this->minRecall = minRecall;
+}
+
+void AutoTuner::setMinOverlap(float minOverlap) {
+    assert(minOverlap > 0 && minOverlap <= 1);
+    this->minOverlap = minOverlap;
+}
+
+void AutoTuner::setSteps(const std::vector<unsigned int> &steps) {
+    assert(!steps.empty());
+    this->steps = steps;
+}
+
+void AutoTuner::setThresholds(const std::vector<cv::Vec2f> &thresholds) {
+    assert(!thresholds.empty());
+    this->thresholds = thresholds;
+}
+
+void AutoTuner::setHashTableCounts(const std::vector<unsigned int> &hashTableCounts) {
+    assert(!hashTableCounts.empty());
+    this->hashTableCounts = hashTableCounts;
+}
+
+void AutoTuner::setHistogramBinCounts(const std::vector<unsigned int> &histogramBinCounts) {
+    assert(!histogramBinCounts.empty());
+    this->histogramBinCounts = histogramBinCounts;
+}
+
+void AutoTuner::setMaxTripletDistances(const std::vector<unsigned int> &maxTripletDistances) {
+    assert(!maxTripletDistances.empty());
+    this->maxTripletDistances = maxTripletDistances;
+}
+
+void AutoTuner::setMinVotesPerTemplate(const std::vector<int> &minVotesPerTemplate) {
+    assert(!minVotesPerTemplate.empty());
+    this->minVotesPerTemplate = minVotesPerTemplate;
+}
@@ -0,0 +1,94 @@
+#ifndef VSB_SEMESTRAL_PROJECT_AUTO_TUNER_H
+#define VSB_SEMESTRAL_PROJECT_AUTO_TUNER_H
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "../core/tuning_params.h"
+#include "../objdetect/classifier.h"
+
+/**
+ * class AutoTuner
+ *
+ * Sweeps classifier parameters (objectness step and thresholds, hash table count, histogram bins,
+ * triplet distance and minimum votes) and measures average detection latency and recall on validation
+ * scenes with known ground truth. Parsed templates, min edgels and trained hash tables are reused across
+ * all configurations that don't change them. Pareto-optimal configurations (no other configuration
+ * is both faster and more accurate) are saved into .yml file, where the fastest configuration
+ * meeting minimum recall is marked as the best one. Tuning runs only in release build (NDEBUG), since debug
+ * visualizations wait for key press in every detection.
+ */
+class AutoTuner {
+private:
+    struct ValidationScene {
+        cv::Mat scene;
+        cv::Mat sceneGrayscale;
+        cv::Mat sceneDepth;
+        cv::Mat sceneDepthNormalized;
+        cv::Mat sceneDepthValid;
+        cv::Mat sceneNormals;
+        ResponseMaps sceneResponseMaps;
+        cv::Mat sceneHue;
+        std::vector<cv::Rect> groundTruth;
+    };
+
+    std::string scenePath; // Path to validation scenes, relative to classifier base path [scene_01/]
+    std::vector<int> sceneIndices; // Indices of validation scenes in scene folder
+    float minRecall; // Accuracy floor used to pick the best configuration [0.5f]
+    float minOverlap; // Minimum intersection over union of matched BB and ground truth BB [0.5f]
+
+    // Swept values
+    std::vector<unsigned int> steps;
+    std::vector<cv::Vec2f> thresholds;
+    std::vector<unsigned int> hashTableCounts;
+    std::vector<unsigned int> histogramBinCounts;
+    std::vector<unsigned int> maxTripletDistances;
+    std::vector<int> minVotesPerTemplate;
+
+    // Methods
+    void loadValidationScenes(Classifier &classifier, std::vector<ValidationScene> &scenes);
+    void loadGroundTruth(Classifier &classifier, int index, std::vector<cv::Rect> &groundTruth);
+    int countFound(const std::vector<cv::Rect> &matchBBs, const std::vector<cv::Rect> &groundTruth);
+    void extractParetoFront(std::vector<TuningParams> &results, std::vector<TuningParams> &front);
+public:
+    // Constructors
+    AutoTuner(std::string scenePath = "scene_01/", std::vector<int> sceneIndices = { 0, 1, 2, 3, 4 }, float minRecall = 0.5f, float minOverlap = 0.5f)
+        : scenePath(scenePath), sceneIndices(sceneIndices), minRecall(minRecall), minOverlap(minOverlap),
+          steps({ 5, 10 }), thresholds({ cv::Vec2f(0.01f, 0.1f) }), hashTableCounts({ 50, 100 }),
+          histogramBinCounts({ 5 }), maxTripletDistances({ 5 }), minVotesPerTemplate({ 3, 4 }) {}
+
+    // Statics
+    static void apply(const TuningParams &params, Classifier &classifier);
+    static TuningParams load(const std::string &fileName, int index = -1);
+
+    // Methods
+    void tune(Classifier &classifier, std::vector<TuningParams> &front);
+    int selectBest(const std::vector<TuningParams> &front) const;
+    void save(const std::string &fileName, const std::vector<TuningParams> &front) const;
+
+    // Getters
+    const std::string &getScenePath() const;
+    const std::vector<int> &getSceneIndices() const;
+    float getMinRecall() const;
+    float getMinOverlap() const;
+    const std::vector<unsigned int> &getSteps() const;
+    const std::vector<cv::Vec2f> &getThresholds() const;
+    const std::vector<unsigned int> &getHashTableCounts() const;
+    const std::vector<unsigned int> &getHistogramBinCounts() const;
+    const std::vector<unsigned int> &getMaxTripletDistances() const;
+    const std::vector<int> &getMinVotesPerTemplate() const;
+
+    // Setters
+    void setScenePath(const std::string &scenePath);
+    void setSceneIndices(const std::vector<int> &sceneIndices);
+    void setMinRecall(float minRecall);
+    void setMinOverlap(float minOverlap);
+    void setSteps(const std::vector<unsigned int> &steps);
+    void setThresholds(const std::vector<cv::Vec2f> &thresholds);
+    void setHashTableCounts(const std::vector<unsigned int> &hashTableCounts);
+    void setHistogramBinCounts(const std::vector<unsigned int> &histogramBinCounts);
+    void setMaxTripletDistances(const std::vector<unsigned int> &maxTripletDistances);
+    void setMinVotesPerTemplate(const std::vector<int> &minVotesPerTemplate);
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_AUTO_TUNER_H
@@ -0,0 +1,513 @@
+#include "config_parser.h"
+#include <omp.h>
+
+// Reads value of given key only if it's present, otherwise keeps current value
+template<typename T>
+static void readValue(const cv::FileNode &node, const std::string &key, T &value) {
+    if (!node[key].empty()) {
+        node[key] >> value;
+    }
+}
+
+void ConfigParser::check(bool condition, const std::string &message) {
+    if (!condition) {
+        errors.push_back(message);
+    }
+}
+
+void ConfigParser::parseParser(const cv::FileNode &node, Classifier &classifier) {
+    // Template folders have no usable default, section is required unless they were already set
+    if (node.empty()) {
+        check(!classifier.getTemplateFolders().empty(), "parser section is missing, parser.templateFolders must be set");
+        return;
+    }
+
+    // Current values are used for missing keys
+    std::string basePath = classifier.getBasePath();
+    std::vector<std::string> templateFolders = classifier.getTemplateFolders();
+    int tplCount = classifier.parser.getTplCount();
+    std::vector<int> indices;
+
+    readValue(node, "basePath", basePath);
+    readValue(node, "templateFolders", templateFolders);
+    readValue(node, "tplCount", tplCount);
+    readValue(node, "indices", indices);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(basePath.length() > 0 && basePath[basePath.length() - 1] == '/', "parser.basePath must end with '/'");
+    check(templateFolders.size() > 0, "parser.templateFolders must contain at least one folder");
+    check(tplCount > 0, "parser.tplCount must be > 0");
+    for (auto &&index : indices) {
+        check(index >= 0 && index < tplCount, "parser.indices must be in interval <0, tplCount)");
+    }
+
+    for (auto &&folder : templateFolders) {
+        cv::FileStorage fs;
+        check(fs.open(basePath + folder + "/gt.yml", cv::FileStorage::READ), "parser.templateFolders: can't open " + basePath + folder + "/gt.yml");
+    }
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.setBasePath(basePath);
+    classifier.setTemplateFolders(templateFolders);
+    classifier.parser.setBasePath(basePath);
+    classifier.parser.setTemplateFolders(templateFolders);
+    classifier.parser.setTplCount(static_cast<unsigned int>(tplCount));
+
+    if (!indices.empty()) {
+        std::unique_ptr<std::vector<int>> pIndices(new std::vector<int>(indices));
+        classifier.parser.setIndices(pIndices);
+    }
+}
+
+void ConfigParser::parseScene(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    std::string scenePath = classifier.getScenePath();
+    std::string sceneName = classifier.getSceneName();
+
+    readValue(node, "scenePath", scenePath);
+    readValue(node, "sceneName", sceneName);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(scenePath.length() > 0 && scenePath[scenePath.length() - 1] == '/', "scene.scenePath must end with '/'");
+    check(sceneName.length() > 0, "scene.sceneName must not be empty");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.setScenePath(scenePath);
+    classifier.setSceneName(sceneName);
+}
+
+void ConfigParser::parseDepth(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int maxHoleSize = classifier.depthPreprocessor.getMaxHoleSize();
+    float maxFillSpread = classifier.depthPreprocessor.getMaxFillSpread();
+    int medianSize = classifier.depthPreprocessor.getMedianSize();
+    int bilateralDiameter = classifier.depthPreprocessor.getBilateralDiameter();
+    float bilateralSigmaDepth = classifier.depthPreprocessor.getBilateralSigmaDepth();
+    float bilateralSigmaSpace = classifier.depthPreprocessor.getBilateralSigmaSpace();
+
+    readValue(node, "maxHoleSize", maxHoleSize);
+    readValue(node, "maxFillSpread", maxFillSpread);
+    readValue(node, "medianSize", medianSize);
+    readValue(node, "bilateralDiameter", bilateralDiameter);
+    readValue(node, "bilateralSigmaDepth", bilateralSigmaDepth);
+    readValue(node, "bilateralSigmaSpace", bilateralSigmaSpace);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(maxHoleSize >= 0, "depth.maxHoleSize must be >= 0");
+    check(maxFillSpread >= 0, "depth.maxFillSpread must be >= 0");
+    check(medianSize == 0 || medianSize == 3 || medianSize == 5, "depth.medianSize must be 0, 3 or 5");
+    check(bilateralDiameter >= 0, "depth.bilateralDiameter must be >= 0");
+    check(bilateralSigmaDepth > 0, "depth.bilateralSigmaDepth must be > 0");
+    check(bilateralSigmaSpace > 0, "depth.bilateralSigmaSpace must be > 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.depthPreprocessor.setMaxHoleSize(static_cast<unsigned int>(maxHoleSize));
+    classifier.depthPreprocessor.setMaxFillSpread(maxFillSpread);
+    classifier.depthPreprocessor.setMedianSize(static_cast<unsigned int>(medianSize));
+    classifier.depthPreprocessor.setBilateralDiameter(static_cast<unsigned int>(bilateralDiameter));
+    classifier.depthPreprocessor.setBilateralSigmaDepth(bilateralSigmaDepth);
+    classifier.depthPreprocessor.setBilateralSigmaSpace(bilateralSigmaSpace);
+}
+
+void ConfigParser::parseNormals(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int planeFit = classifier.normalEstimator.isPlaneFit();
+    int radius = classifier.normalEstimator.getRadius();
+
+    readValue(node, "planeFit", planeFit);
+    readValue(node, "radius", radius);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(radius > 0, "normals.radius must be > 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.normalEstimator.setPlaneFit(planeFit != 0);
+    classifier.normalEstimator.setRadius(static_cast<unsigned int>(radius));
+}
+
+void ConfigParser::parseGradients(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int enabled = classifier.gradientResponse.isEnabled();
+    float minMagnitude = classifier.gradientResponse.getMinMagnitude();
+    int spreadSize = classifier.gradientResponse.getSpreadSize();
+
+    readValue(node, "enabled", enabled);
+    readValue(node, "minMagnitude", minMagnitude);
+    readValue(node, "spreadSize", spreadSize);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(minMagnitude >= 0, "gradients.minMagnitude must be >= 0");
+    check(spreadSize > 0, "gradients.spreadSize must be > 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.gradientResponse.setEnabled(enabled != 0);
+    classifier.gradientResponse.setMinMagnitude(minMagnitude);
+    classifier.gradientResponse.setSpreadSize(static_cast<unsigned int>(spreadSize));
+}
+
+void ConfigParser::parseColor(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int enabled = classifier.hueQuantizer.isEnabled();
+    int hueBins = classifier.hueQuantizer.getHueBins();
+    int minSaturation = classifier.hueQuantizer.getMinSaturation();
+    int minValue = classifier.hueQuantizer.getMinValue();
+
+    readValue(node, "enabled", enabled);
+    readValue(node, "hueBins", hueBins);
+    readValue(node, "minSaturation", minSaturation);
+    readValue(node, "minValue", minValue);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(hueBins > 0 && hueBins <= 180, "color.hueBins must be in interval <1, 180>");
+    check(minSaturation >= 0 && minSaturation <= 255, "color.minSaturation must be in interval <0, 255>");
+    check(minValue >= 0 && minValue <= 255, "color.minValue must be in interval <0, 255>");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.hueQuantizer.setEnabled(enabled != 0);
+    classifier.hueQuantizer.setHueBins(hueBins);
+    classifier.hueQuantizer.setMinSaturation(minSaturation);
+    classifier.hueQuantizer.setMinValue(minValue);
+}
+
+void ConfigParser::parseObjectness(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int step = classifier.objectness.getStep();
+    float minThreshold = classifier.objectness.getMinThreshold();
+    float maxThreshold = classifier.objectness.getMaxThreshold();
+    float matchThresholdFactor = classifier.objectness.getMatchThresholdFactor();
+    float slidingWindowSizeFactor = classifier.objectness.getSlidingWindowSizeFactor();
+    int pyramidLevels = classifier.objectness.getPyramidLevels();
+    int coalesceRadius = classifier.objectness.getCoalesceRadius();
+
+    readValue(node, "step", step);
+    readValue(node, "minThreshold", minThreshold);
+    readValue(node, "maxThreshold", maxThreshold);
+    readValue(node, "matchThresholdFactor", matchThresholdFactor);
+    readValue(node, "slidingWindowSizeFactor", slidingWindowSizeFactor);
+    readValue(node, "pyramidLevels", pyramidLevels);
+    readValue(node, "coalesceRadius", coalesceRadius);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(step > 0, "objectness.step must be > 0");
+    check(minThreshold >= 0, "objectness.minThreshold must be >= 0");
+    check(maxThreshold > minThreshold, "objectness.maxThreshold must be > minThreshold");
+    check(matchThresholdFactor > 0, "objectness.matchThresholdFactor must be > 0");
+    check(slidingWindowSizeFactor > 0, "objectness.slidingWindowSizeFactor must be > 0");
+    check(pyramidLevels >= 0 && pyramidLevels <= 4, "objectness.pyramidLevels must be in interval <0, 4>");
+    check(coalesceRadius >= 0, "objectness.coalesceRadius must be >= 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.objectness.setStep(static_cast<unsigned int>(step));
+    classifier.objectness.setMinThreshold(minThreshold);
+    classifier.objectness.setMaxThreshold(maxThreshold);
+    classifier.objectness.setMatchThresholdFactor(matchThresholdFactor);
+    classifier.objectness.setSlidingWindowSizeFactor(slidingWindowSizeFactor);
+    classifier.objectness.setPyramidLevels(static_cast<unsigned int>(pyramidLevels));
+    classifier.objectness.setCoalesceRadius(static_cast<unsigned int>(coalesceRadius));
+}
+
+void ConfigParser::parseHasher(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    cv::Size grid = classifier.hasher.getReferencePointsGrid();
+    std::vector<int> referencePointsGrid = { grid.width, grid.height };
+    int hashTableCount = classifier.hasher.getHashTableCount();
+    int histogramBinCount = classifier.hasher.getHistogramBinCount();
+    int minVotesPerTemplate = classifier.hasher.getMinVotesPerTemplate();
+    int maxTripletDistance = classifier.hasher.getMaxTripletDistance();
+    float depthScale = classifier.hasher.getDepthScale();
+    float depthBand = classifier.hasher.getDepthBand();
+    int seed = static_cast<int>(classifier.hasher.getSeed());
+    int bitsetVoting = classifier.hasher.isBitsetVoting();
+    int perObjectIndices = classifier.hasher.isPerObjectIndices();
+
+    readValue(node, "referencePointsGrid", referencePointsGrid);
+    readValue(node, "hashTableCount", hashTableCount);
+    readValue(node, "histogramBinCount", histogramBinCount);
+    readValue(node, "minVotesPerTemplate", minVotesPerTemplate);
+    readValue(node, "maxTripletDistance", maxTripletDistance);
+    readValue(node, "depthScale", depthScale);
+    readValue(node, "depthBand", depthBand);
+    readValue(node, "seed", seed);
+    readValue(node, "bitsetVoting", bitsetVoting);
+    readValue(node, "perObjectIndices", perObjectIndices);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(referencePointsGrid.size() == 2, "hasher.referencePointsGrid must be [width, height]");
+    if (errors.size() > errorsCount) return;
+
+    check(referencePointsGrid[0] > 0 && referencePointsGrid[1] > 0, "hasher.referencePointsGrid must be > 0");
+    check(hashTableCount > 0, "hasher.hashTableCount must be > 0");
+    check(histogramBinCount > 0, "hasher.histogramBinCount must be > 0");
+    check(minVotesPerTemplate > 0 && minVotesPerTemplate <= hashTableCount, "hasher.minVotesPerTemplate must be in interval <1, hashTableCount>");
+    check(maxTripletDistance > 1, "hasher.maxTripletDistance must be > 1");
+    check(maxTripletDistance < std::min(referencePointsGrid[0], referencePointsGrid[1]), "hasher.maxTripletDistance must be < referencePointsGrid");
+    check(depthScale > 0, "hasher.depthScale must be > 0");
+    check(depthBand >= 0 && depthBand < 1, "hasher.depthBand must be in interval <0, 1)");
+    check(seed >= 0, "hasher.seed must be >= 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.hasher.setReferencePointsGrid(cv::Size(referencePointsGrid[0], referencePointsGrid[1]));
+    classifier.hasher.setHashTableCount(static_cast<unsigned int>(hashTableCount));
+    classifier.hasher.setHistogramBinCount(static_cast<unsigned int>(histogramBinCount));
+    classifier.hasher.setMinVotesPerTemplate(minVotesPerTemplate);
+    classifier.hasher.setMaxTripletDistance(static_cast<unsigned int>(maxTripletDistance));
+    classifier.hasher.setDepthScale(depthScale);
+    classifier.hasher.setDepthBand(depthBand);
+    classifier.hasher.setSeed(static_cast<uint64_t>(seed));
+    classifier.hasher.setBitsetVoting(bitsetVoting != 0);
+    classifier.hasher.setPerObjectIndices(perObjectIndices != 0);
+}
+
+void ConfigParser::parseMatcher(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int featureMatching = classifier.templateMatcher.isFeatureMatching();
+    int featurePointsCount = classifier.templateMatcher.getFeaturePointsCount();
+    int scaleNormalization = classifier.templateMatcher.isScaleNormalization();
+    float minScale = classifier.templateMatcher.getMinScale();
+    float maxScale = classifier.templateMatcher.getMaxScale();
+    float minScore = classifier.templateMatcher.getMinScore();
+    int pyramidLevels = classifier.templateMatcher.getPyramidLevels();
+    float coarseMinScore = classifier.templateMatcher.getCoarseMinScore();
+    int viewpointNeighbours = classifier.templateMatcher.getViewpointNeighbours();
+    int viewpointSearch = classifier.templateMatcher.isViewpointSearch();
+    int viewpointExpandCount = classifier.templateMatcher.getViewpointExpandCount();
+    int treeSearch = classifier.templateMatcher.isTreeSearch();
+    int treeBranching = classifier.templateMatcher.getTreeBranching();
+    int treeLeafSize = classifier.templateMatcher.getTreeLeafSize();
+    float treeScoreMargin = classifier.templateMatcher.getTreeScoreMargin();
+    float minNormalScore = classifier.templateMatcher.getMinNormalScore();
+    float minGradientScore = classifier.templateMatcher.getMinGradientScore();
+    float minColorScore = classifier.templateMatcher.getMinColorScore();
+    int hueTolerance = classifier.templateMatcher.getHueTolerance();
+    int earlyTermination = classifier.templateMatcher.isEarlyTermination();
+
+    readValue(node, "featureMatching", featureMatching);
+    readValue(node, "featurePointsCount", featurePointsCount);
+    readValue(node, "scaleNormalization", scaleNormalization);
+    readValue(node, "minScale", minScale);
+    readValue(node, "maxScale", maxScale);
+    readValue(node, "minScore", minScore);
+    readValue(node, "pyramidLevels", pyramidLevels);
+    readValue(node, "coarseMinScore", coarseMinScore);
+    readValue(node, "viewpointNeighbours", viewpointNeighbours);
+    readValue(node, "viewpointSearch", viewpointSearch);
+    readValue(node, "viewpointExpandCount", viewpointExpandCount);
+    readValue(node, "treeSearch", treeSearch);
+    readValue(node, "treeBranching", treeBranching);
+    readValue(node, "treeLeafSize", treeLeafSize);
+    readValue(node, "treeScoreMargin", treeScoreMargin);
+    readValue(node, "minNormalScore", minNormalScore);
+    readValue(node, "minGradientScore", minGradientScore);
+    readValue(node, "minColorScore", minColorScore);
+    readValue(node, "hueTolerance", hueTolerance);
+    readValue(node, "earlyTermination", earlyTermination);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(featurePointsCount > 0, "matcher.featurePointsCount must be > 0");
+    check(minScale > 0 && minScale <= maxScale, "matcher.minScale must be in interval (0, maxScale>");
+    check(minScore >= 0 && minScore <= 1, "matcher.minScore must be in interval <0, 1>");
+    check(pyramidLevels >= 0 && pyramidLevels <= 4, "matcher.pyramidLevels must be in interval <0, 4>");
+    check(coarseMinScore >= 0 && coarseMinScore <= 1, "matcher.coarseMinScore must be in interval <0, 1>");
+    check(viewpointNeighbours >= 0, "matcher.viewpointNeighbours must be >= 0");
+    check(viewpointSearch == 0 || viewpointNeighbours > 0, "matcher.viewpointSearch requires viewpointNeighbours > 0");
+    check(viewpointExpandCount > 0, "matcher.viewpointExpandCount must be > 0");
+    check(treeSearch == 0 || viewpointSearch == 0, "matcher.treeSearch and matcher.viewpointSearch can't be used together");
+    check(treeBranching > 1, "matcher.treeBranching must be > 1");
+    check(treeLeafSize > 0, "matcher.treeLeafSize must be > 0");
+    check(treeScoreMargin >= 0, "matcher.treeScoreMargin must be >= 0");
+    check(minNormalScore >= 0 && minNormalScore <= 1, "matcher.minNormalScore must be in interval <0, 1>");
+    check(minGradientScore >= 0 && minGradientScore <= 1, "matcher.minGradientScore must be in interval <0, 1>");
+    check(minColorScore >= 0 && minColorScore <= 1, "matcher.minColorScore must be in interval <0, 1>");
+    check(hueTolerance >= 0, "matcher.hueTolerance must be >= 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.templateMatcher.setFeatureMatching(featureMatching != 0);
+    classifier.templateMatcher.setFeaturePointsCount(static_cast<uint>(featurePointsCount));
+    classifier.templateMatcher.setScaleNormalization(scaleNormalization != 0);
+    classifier.templateMatcher.setMinScale(minScale);
+    classifier.templateMatcher.setMaxScale(maxScale);
+    classifier.templateMatcher.setMinScore(minScore);
+    classifier.templateMatcher.setPyramidLevels(static_cast<unsigned int>(pyramidLevels));
+    classifier.templateMatcher.setCoarseMinScore(coarseMinScore);
+    classifier.templateMatcher.setViewpointNeighbours(static_cast<uint>(viewpointNeighbours));
+    classifier.templateMatcher.setViewpointSearch(viewpointSearch != 0);
+    classifier.templateMatcher.setViewpointExpandCount(static_cast<uint>(viewpointExpandCount));
+    classifier.templateMatcher.setTreeSearch(treeSearch != 0);
+    classifier.templateMatcher.setTreeBranching(static_cast<uint>(treeBranching));
+    classifier.templateMatcher.setTreeLeafSize(static_cast<uint>(treeLeafSize));
+    classifier.templateMatcher.setTreeScoreMargin(treeScoreMargin);
+    classifier.templateMatcher.setMinNormalScore(minNormalScore);
+    classifier.templateMatcher.setMinGradientScore(minGradientScore);
+    classifier.templateMatcher.setMinColorScore(minColorScore);
+    classifier.templateMatcher.setHueTolerance(static_cast<uint>(hueTolerance));
+    classifier.templateMatcher.setEarlyTermination(earlyTermination != 0);
+}
+
+void ConfigParser::parseTracking(const cv::FileNode &node, Classifier &classifier) {
+    if (node.empty()) return;
+
+    // Current values are used for missing keys
+    int enabled = classifier.tracker.isEnabled();
+    int redetectInterval = classifier.tracker.getRedetectInterval();
+    int searchRadius = classifier.tracker.getSearchRadius();
+    int neighbourCount = classifier.tracker.getNeighbourCount();
+
+    readValue(node, "enabled", enabled);
+    readValue(node, "redetectInterval", redetectInterval);
+    readValue(node, "searchRadius", searchRadius);
+    readValue(node, "neighbourCount", neighbourCount);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(redetectInterval > 0, "tracking.redetectInterval must be > 0");
+    check(searchRadius >= 0, "tracking.searchRadius must be >= 0");
+    check(neighbourCount >= 0, "tracking.neighbourCount must be >= 0");
+
+    if (errors.size() > errorsCount) return;
+
+    // Apply
+    classifier.tracker.setEnabled(enabled != 0);
+    classifier.tracker.setRedetectInterval(static_cast<unsigned int>(redetectInterval));
+    classifier.tracker.setSearchRadius(searchRadius);
+    classifier.tracker.setNeighbourCount(static_cast<unsigned int>(neighbourCount));
+}
+
+void ConfigParser::checkDependencies(Classifier &classifier) {
+    // Values of different sections are checked after all sections are applied, so none of them is stale
+    const float depthBand = classifier.hasher.getDepthBand();
+    const bool scaleNormalization = classifier.templateMatcher.isScaleNormalization();
+    check(!scaleNormalization || depthBand == 0 ||
+          (1 - depthBand >= classifier.templateMatcher.getMinScale() && 1 + depthBand <= classifier.templateMatcher.getMaxScale()),
+          "hasher.depthBand must lie within <matcher.minScale, matcher.maxScale> (band of template distance / window depth is the scale)");
+
+    // Matcher tests are skipped without scene data they verify against
+    check(classifier.templateMatcher.getMinNormalScore() == 0 || classifier.normalEstimator.isPlaneFit(),
+          "matcher.minNormalScore requires normals.planeFit");
+    check(classifier.templateMatcher.getMinGradientScore() == 0 || classifier.gradientResponse.isEnabled(),
+          "matcher.minGradientScore requires gradients.enabled");
+    check(classifier.templateMatcher.getMinColorScore() == 0 || classifier.hueQuantizer.isEnabled(),
+          "matcher.minColorScore requires color.enabled");
+
+    // Only feature matching refines template position around coalesced windows, dense matching would lose suppressed positions
+    check(classifier.objectness.getCoalesceRadius() == 0 || classifier.templateMatcher.isFeatureMatching(),
+          "objectness.coalesceRadius requires matcher.featureMatching");
+
+    // Tracking searches around previous TemplateMatch results, which only feature matching produces
+    check(!classifier.tracker.isEnabled() || classifier.templateMatcher.isFeatureMatching(), "tracking.enabled requires matcher.featureMatching");
+}
+
+void ConfigParser::parseThreading(const cv::FileNode &node) {
+    if (node.empty()) return;
+
+    // 0 keeps default number of threads (number of cores)
+    int numThreads = 0;
+    readValue(node, "numThreads", numThreads);
+
+    // Validate
+    const size_t errorsCount = errors.size();
+    check(numThreads >= 0, "threading.numThreads must be >= 0");
+
+    if (errors.size() > errorsCount || numThreads == 0) return;
+
+    // Apply to both OpenMP and OpenCV parallel regions
+    omp_set_num_threads(numThreads);
+    cv::setNumThreads(numThreads);
+}
+
+bool ConfigParser::parse(const std::string &fileName, Classifier &classifier) {
+    // Load config
+    cv::FileStorage fs;
+    if (!fs.open(fileName, cv::FileStorage::READ)) {
+        errors.push_back("can't open config file " + fileName);
+        std::cerr << "Config error: " << errors.back() << std::endl;
+        return false;
+    }
+
+    std::cout << "Loading config " << fileName << "... ";
+    bool valid = parse(fs.root(), classifier);
+    fs.release();
+
+    return valid;
+}
+
+bool ConfigParser::parse(const cv::FileNode &root, Classifier &classifier) {
+    errors.clear();
+
+    // Parse each section
+    parseParser(root["parser"], classifier);
+    parseScene(root["scene"], classifier);
+    parseDepth(root["depth"], classifier);
+    parseNormals(root["normals"], classifier);
+    parseGradients(root["gradients"], classifier);
+    parseColor(root["color"], classifier);
+    parseObjectness(root["objectness"], classifier);
+    parseHasher(root["hasher"], classifier);
+    parseMatcher(root["matcher"], classifier);
+    parseTracking(root["tracking"], classifier);
+    parseThreading(root["threading"]);
+
+    // Dependencies between sections are checked only if all sections are valid
+    if (errors.empty()) {
+        checkDependencies(classifier);
+    }
+
+    // Print validation errors
+    if (!errors.empty()) {
+        std::cerr << "Config is not valid:" << std::endl;
+        for (auto &&error : errors) {
+            std::cerr << "  |_ " << error << std::endl;
+        }
+
+        return false;
+    }
+
+    std::cout << "DONE!" << std::endl << std::endl;
+    return true;
+}
+
+const std::vector<std::string> &ConfigParser::getErrors() const {
+    return errors;
+}
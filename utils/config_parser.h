@@ -0,0 +1,43 @@
+#ifndef VSB_SEMESTRAL_PROJECT_CONFIG_PARSER_H
+#define VSB_SEMESTRAL_PROJECT_CONFIG_PARSER_H
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "../objdetect/classifier.h"
+
+/**
+ * class ConfigParser
+ *
+ * Utility class used to load all pipeline parameters from .yml (or .json) configuration file
+ * using cv::FileStorage, so they can be tuned without recompiling. File can contain parser, scene,
+ * depth, normals, gradients, color, objectness, hasher, matcher, tracking and threading sections, every missing section or key keeps
+ * classifier default value. All values are validated before they're applied to the classifier.
+ */
+class ConfigParser {
+private:
+    std::vector<std::string> errors;
+
+    void check(bool condition, const std::string &message);
+    void parseParser(const cv::FileNode &node, Classifier &classifier);
+    void parseScene(const cv::FileNode &node, Classifier &classifier);
+    void parseDepth(const cv::FileNode &node, Classifier &classifier);
+    void parseNormals(const cv::FileNode &node, Classifier &classifier);
+    void parseGradients(const cv::FileNode &node, Classifier &classifier);
+    void parseColor(const cv::FileNode &node, Classifier &classifier);
+    void parseObjectness(const cv::FileNode &node, Classifier &classifier);
+    void parseHasher(const cv::FileNode &node, Classifier &classifier);
+    void parseMatcher(const cv::FileNode &node, Classifier &classifier);
+    void parseTracking(const cv::FileNode &node, Classifier &classifier);
+    void parseThreading(const cv::FileNode &node);
+    void checkDependencies(Classifier &classifier);
+public:
+    // Methods
+    bool parse(const std::string &fileName, Classifier &classifier);
+    bool parse(const cv::FileNode &root, Classifier &classifier);
+
+    // Getters
+    const std::vector<std::string> &getErrors() const;
+};
+
+#endif //VSB_SEMESTRAL_PROJECT_CONFIG_PARSER_H
@@ -1,105 +1,94 @@
 #include "template_parser.h"
 #include <cassert>
+#include <numeric>
 
 int TemplateParser::idCounter = 0;
 
-void TemplateParser::parse(std::vector<TemplateGroup> &groups) {
+void TemplateParser::parse(TemplateStore &store, std::vector<TemplateGroup> &groups, const HueQuantizer &hueQuantizer) {
     // Checks
     assert(this->templateFolders.size() > 0);
+    assert(store.empty());
     int parsedTemplatesCount = 0;
 
-    // Parse
+    // Parse .yml params of all templates first, to know size of the whole catalog
     for (auto &&tplName : this->templateFolders) {
-        std::vector<Template> templates;
+        groups.push_back(TemplateGroup(tplName));
+        TemplateGroup &group = groups.back();
 
         // If indices are not null, parse specified ids
         if (this->indices) {
-            parseTemplate(templates, tplName, this->indices);
+            parseTemplate(store, group, this->indices);
         } else {
-            parseTemplate(templates, tplName);
+            parseTemplate(store, group);
         }
 
-        // Push to groups vector
-        groups.push_back(TemplateGroup(tplName, templates));
-        parsedTemplatesCount += templates.size();
-        std::cout << "  |_ Parsed: " << tplName << ", templates size: " << templates.size() << std::endl;
+        parsedTemplatesCount += group.templates.size();
+        std::cout << "  |_ Parsed: " << tplName << ", templates size: " << group.templates.size() << std::endl;
     }
 
-    std::cout << "  |_ Parsed total: " << parsedTemplatesCount << " templates" << std::endl;
-}
-
-void TemplateParser::parseTemplate(std::vector<Template> &templates, std::string tplName) {
-    // Load obj_gt
-    cv::FileStorage fs;
-    fs.open(this->basePath + tplName + "/gt.yml", cv::FileStorage::READ);
-    assert(fs.isOpened());
-
-    for (int i = 0; i < this->tplCount; i++) {
-        std::string index = "tpl_" + std::to_string(i);
-        cv::FileNode objGt = fs[index];
-
-        // Parse template gt file
-        templates.push_back(parseGt(i, this->basePath + tplName, objGt));
-        this->idCounter++;
+    // Allocate pixel data of all templates at once and load images into it
+    store.allocateArena(hueQuantizer.isEnabled());
+    for (auto &group : groups) {
+        for (auto &handle : group.templates) {
+            loadImages(store[handle], this->basePath + group.folderName, hueQuantizer);
+        }
     }
 
-    // Load obj_info
-    fs.open(this->basePath + tplName + "/info.yml", cv::FileStorage::READ);
-    assert(fs.isOpened());
-
-    for (int i = 0; i < this->tplCount; i++) {
-        std::string index = "tpl_" + std::to_string(i);
-        cv::FileNode objGt = fs[index];
+    std::cout << "  |_ Parsed total: " << parsedTemplatesCount << " templates, " << store.getArenaSize() / 1024 << "kB" << std::endl;
+}
 
-        // Parse template info file
-        parseInfo(templates[i], objGt);
-    }
+void TemplateParser::parseTemplate(TemplateStore &store, TemplateGroup &group) {
+    // Parse all templates in folder
+    std::vector<int> tplIndices(this->tplCount);
+    std::iota(tplIndices.begin(), tplIndices.end(), 0);
+    parseTemplate(store, group, tplIndices);
+}
 
-    fs.release();
+void TemplateParser::parseTemplate(TemplateStore &store, TemplateGroup &group, std::unique_ptr<std::vector<int>> &indices) {
+    parseTemplate(store, group, *indices);
 }
 
-void TemplateParser::parseTemplate(std::vector<Template> &templates, std::string tplName, std::unique_ptr<std::vector<int>> &indices) {
-    // Load obj_gt
-    cv::FileStorage fs;
-    fs.open(this->basePath + tplName + "/gt.yml", cv::FileStorage::READ);
-    assert(fs.isOpened());
+void TemplateParser::parseTemplate(TemplateStore &store, TemplateGroup &group, const std::vector<int> &tplIndices) {
+    // Load obj_gt and obj_info
+    cv::FileStorage fsGt, fsInfo;
+    fsGt.open(this->basePath + group.folderName + "/gt.yml", cv::FileStorage::READ);
+    fsInfo.open(this->basePath + group.folderName + "/info.yml", cv::FileStorage::READ);
+    assert(fsGt.isOpened());
+    assert(fsInfo.isOpened());
 
-    for (int i = 0; i < (*indices).size(); i++) {
-        int tplIndex = (*indices)[i];
+    for (auto &&tplIndex : tplIndices) {
         std::string index = "tpl_" + std::to_string(tplIndex);
-        cv::FileNode objGt = fs[index];
+        cv::FileNode objGt = fsGt[index];
+        cv::FileNode objInfo = fsInfo[index];
 
-        // Parse template gt file
-        templates.push_back(parseGt(tplIndex, this->basePath + tplName, objGt));
+        // Parse template gt and info file, template is complete before it's pushed to the store
+        Template t = parseGt(tplIndex, objGt);
+        parseInfo(t, objInfo);
+        group.templates.push_back(store.push(t));
         this->idCounter++;
     }
 
-    // Load obj_info
-    fs.open(this->basePath + tplName + "/info.yml", cv::FileStorage::READ);
-    assert(fs.isOpened());
-
-    for (int i = 0; i < (*indices).size(); i++) {
-        int tplIndex = (*indices)[i];
-        std::string index = "tpl_" + std::to_string(tplIndex);
-        cv::FileNode objGt = fs[index];
-
-        // Parse template info file
-        parseInfo(templates[i], objGt);
-    }
-
-    fs.release();
+    fsGt.release();
+    fsInfo.release();
 }
 
-Template TemplateParser::parseGt(int index, std::string path, cv::FileNode &gtNode) {
+Template TemplateParser::parseGt(int index, cv::FileNode &gtNode) {
     // Init template param matrices
     std::vector<float> vCamRm2c, vCamTm2c;
     std::vector<int> vObjBB;
+    int objId;
 
     // Nodes containing matrices and vectors to parseTemplate
     gtNode["obj_bb"] >> vObjBB;
+    gtNode["obj_id"] >> objId;
     gtNode["cam_R_m2c"] >> vCamRm2c;
     gtNode["cam_t_m2c"] >> vCamTm2c;
 
+    // Checks
+    assert(!vObjBB.empty());
+    assert(!vCamRm2c.empty());
+    assert(!vCamTm2c.empty());
+
     // Parse objBB
     cv::Rect objBB(vObjBB[0], vObjBB[1], vObjBB[2], vObjBB[3]);
 
@@ -108,34 +97,88 @@ Template TemplateParser::parseGt(int index, std::string path, cv::FileNode &gtNo
     ss << std::setw(4) << std::setfill('0') << index;
     std::string fileName = ss.str();
 
-    // Load image
-    cv::Mat src = cv::imread(path + "/rgb/" + fileName + ".png", CV_LOAD_IMAGE_GRAYSCALE);
-    cv::Mat srcDepth = cv::imread(path + "/depth/" + fileName + ".png", CV_LOAD_IMAGE_UNCHANGED);
+    // Images are loaded later, once arena for the whole catalog is allocated
+    return Template(
+        this->idCounter, objId, fileName, cv::Mat(), cv::Mat(), objBB,
+        cv::Matx33f(vCamRm2c.data()),
+        cv::Vec3d(vCamTm2c[0], vCamTm2c[1], vCamTm2c[2])
+    );
+}
 
-    // Crop image using objBB
-    src = src(objBB);
-    srcDepth = srcDepth(objBB);
+void TemplateParser::loadImages(Template &t, std::string path, const HueQuantizer &hueQuantizer) {
+    // Checks, images should point into allocated arena
+    assert(!t.src.empty());
+    assert(!t.srcDepth.empty());
+    assert(t.srcHue.empty() != hueQuantizer.isEnabled());
+    const uchar *srcData = t.src.data, *srcDepthData = t.srcDepth.data, *srcHueData = t.srcHue.data;
+
+    // Load image, color is needed only to quantize hue, only intensity is kept
+    cv::Mat src;
+    if (hueQuantizer.isEnabled()) {
+        cv::Mat srcColor = cv::imread(path + "/rgb/" + t.fileName + ".png", CV_LOAD_IMAGE_COLOR);
+        assert(!srcColor.empty());
+
+        cv::Mat srcHue;
+        hueQuantizer.quantize(srcColor(t.objBB), srcHue);
+        srcHue.copyTo(t.srcHue);
+        cv::cvtColor(srcColor, src, CV_BGR2GRAY);
+    } else {
+        src = cv::imread(path + "/rgb/" + t.fileName + ".png", CV_LOAD_IMAGE_GRAYSCALE);
+    }
 
-    // Convert to float
-    src.convertTo(src, CV_32F, 1.0f / 255.0f);
-    srcDepth.convertTo(srcDepth, CV_32F); // because of surface normal calculation, don't doo normalization
+    cv::Mat srcDepth = cv::imread(path + "/depth/" + t.fileName + ".png", CV_LOAD_IMAGE_UNCHANGED);
 
     // Checks
-    assert(!vObjBB.empty());
-    assert(!vCamRm2c.empty());
-    assert(!vCamTm2c.empty());
     assert(!src.empty());
     assert(!srcDepth.empty());
 
-    // Matrix type checks
-    assert(src.type() == 5); // CV_32FC1
-    assert(srcDepth.type() == 5); // CV_32FC1
+    // Matrix type checks, images are kept in native 8-bit intensity and 16-bit depth form to save memory
+    assert(src.type() == 0); // CV_8UC1
+    assert(srcDepth.type() == 2); // CV_16UC1
 
-    return Template(
-        this->idCounter, fileName, src, srcDepth, objBB,
-        cv::Mat(3, 3, CV_32FC1, vCamRm2c.data()).clone(),
-        cv::Vec3d(vCamTm2c[0], vCamTm2c[1], vCamTm2c[2])
-    );
+    // Crop image using objBB and copy it into the arena
+    src(t.objBB).copyTo(t.src);
+    srcDepth(t.objBB).copyTo(t.srcDepth);
+
+    // Copy should not reallocate
+    assert(t.src.data == srcData);
+    assert(t.srcDepth.data == srcDepthData);
+    assert(t.srcHue.data == srcHueData);
+
+    extractForeground(t);
+}
+
+void TemplateParser::extractForeground(Template &t) {
+    // Checks
+    assert(!t.src.empty());
+
+    t.foregroundSpans.clear();
+    t.foregroundArea = 0;
+    int minX = t.src.cols, minY = t.src.rows, maxX = -1, maxY = -1;
+
+    // Encode non-black pixels of each row as spans
+    for (int y = 0; y < t.src.rows; y++) {
+        const uchar *row = t.src.ptr<uchar>(y);
+
+        for (int x = 0; x < t.src.cols;) {
+            if (row[x] == 0) {
+                x++;
+                continue;
+            }
+
+            const int start = x;
+            while (x < t.src.cols && row[x] > 0) x++;
+            t.foregroundSpans.push_back(Template::Span(y, start, x - start));
+            t.foregroundArea += x - start;
+
+            minX = std::min(minX, start);
+            maxX = std::max(maxX, x - 1);
+            minY = std::min(minY, y);
+            maxY = y;
+        }
+    }
+
+    t.innerBB = (maxX < 0) ? cv::Rect() : cv::Rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
 }
 
 void TemplateParser::parseInfo(Template &tpl, cv::FileNode &infoNode) {
@@ -154,7 +197,7 @@ void TemplateParser::parseInfo(Template &tpl, cv::FileNode &infoNode) {
     // Assign new params to template
     tpl.elev = elev;
     tpl.mode = mode;
-    tpl.camK = cv::Mat(3, 3, CV_32FC1, vCamK.data()).clone();
+    tpl.camK = cv::Matx33f(vCamK.data());
 }
 
 void TemplateParser::clearIndices() {
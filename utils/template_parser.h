@@ -4,6 +4,8 @@
 #include <string>
 #include "../core/template.h"
 #include "../core/template_group.h"
+#include "../core/template_store.h"
+#include "../objdetect/hue_quantizer.h"
 
 /**
  * class TemplateParser
@@ -18,17 +20,20 @@ private:
     std::vector<std::string> templateFolders;
     std::unique_ptr<std::vector<int>> indices;
 
-    Template parseGt(int index, std::string path, cv::FileNode &gtNode);
+    Template parseGt(int index, cv::FileNode &gtNode);
     void parseInfo(Template &tpl, cv::FileNode &infoNode);
+    void loadImages(Template &t, std::string path, const HueQuantizer &hueQuantizer);
+    void extractForeground(Template &t);
 public:
     static int idCounter;
 
     TemplateParser(const std::string basePath = "/data", std::vector<std::string> templateFolders = {}, unsigned int tplCount = 1296)
         : basePath(basePath), templateFolders(templateFolders), tplCount(tplCount) {}
 
-    void parse(std::vector<TemplateGroup> &groups);
-    void parseTemplate(std::vector<Template> &templates, std::string tplName);
-    void parseTemplate(std::vector<Template> &templates, std::string tplName, std::unique_ptr<std::vector<int>> &indices);
+    void parse(TemplateStore &store, std::vector<TemplateGroup> &groups, const HueQuantizer &hueQuantizer);
+    void parseTemplate(TemplateStore &store, TemplateGroup &group);
+    void parseTemplate(TemplateStore &store, TemplateGroup &group, std::unique_ptr<std::vector<int>> &indices);
+    void parseTemplate(TemplateStore &store, TemplateGroup &group, const std::vector<int> &tplIndices);
     void clearIndices();
 
     // Getters